@@ -94,6 +94,7 @@ extern "C"
 
 #define rotateOptoKey_Pin               GPIO_PIN_0
 #define rotateOptoKey_GPIO_Port         GPIOA
+#define rotateOptoKey_EXTI_IRQn         EXTI0_1_IRQn
 
 /* --------------------------------------------- Key ---------------------------------------*/
 #define powerKey_Pin                    GPIO_PIN_14
@@ -102,6 +103,7 @@ extern "C"
 
 #define touchKey_Pin                    GPIO_PIN_15
 #define touchKey_GPIO_Port              GPIOC
+#define touchKey_EXTI_IRQn              EXTI4_15_IRQn
 
 /* --------------------------------------------- Power ---------------------------------------*/
 #define batVol_Pin                      GPIO_PIN_1
@@ -124,6 +126,7 @@ extern "C"
 /* --------------------------------------------- Senser ---------------------------------------*/
 #define outputOptoKey_Pin               GPIO_PIN_2
 #define outputOptoKey_GPIO_Port         GPIOB
+#define outputOptoKey_EXTI_IRQn         EXTI2_3_IRQn
 
 /* --------------------------------------------- Buzzer ---------------------------------------*/
 #define buzzer_Pin                      GPIO_PIN_11
@@ -15,6 +15,26 @@ typedef enum
 } TM1639_KeyState_e; // TM1639按键状态枚举
 
 
+// 总线物理层选择：CPU翻转GPIO，或TIM16更新事件触发DMA写GPIOA->BSRR
+#define TM1639_PHY_BITBANG 0
+#define TM1639_PHY_DMA 1
+#ifndef TM1639_PHY
+#define TM1639_PHY TM1639_PHY_BITBANG
+#endif
+
+// 7段码各段定义
+#define SEG_A 0x01  // 上
+#define SEG_B 0x02  // 右上
+#define SEG_C 0x04  // 右下
+#define SEG_D 0x08  // 下
+#define SEG_E 0x10  // 左下
+#define SEG_F 0x20  // 左上
+#define SEG_G 0x40  // 中
+#define SEG_DP 0x80 // 小数点
+
+// 字库中无法显示的字符使用的备用字形(上中下三横)
+#define TM1639_GLYPH_FALLBACK (SEG_A | SEG_D | SEG_G)
+
 // 按键数量
 #define TM1639KEY_AMOUNT 5
 
@@ -40,35 +60,102 @@ typedef enum
     TM1639KEY_CLICKED,
     TM1639KEY_LONG_PRESSED,
     TM1639KEY_LONG_PRESSED_BACK,
+    TM1639KEY_REPEAT,
 } TM1639KeyState_e;
 
-// 按键信息结构体
+
+// 显示寄存器数量(C0H-CFH)
+#define TM1639_FB_SIZE 16
+
+// 显示刷新总线耗时统计
+typedef struct
+{
+    uint32_t frames;       // 已刷新帧数
+    uint8_t last_bytes;    // 上一帧总线字节数(含命令)
+    uint32_t last_cycles;  // 上一帧总线耗时(CPU周期)
+    uint32_t max_cycles;   // 最大单帧耗时(CPU周期)
+    uint32_t total_cycles; // 累计耗时(CPU周期)
+    uint32_t key_reads;    // 读键次数
+    uint32_t key_cycles;   // 读键累计耗时(CPU周期)
+} TM1639BusStat_t;
+
+// 显示功耗调节默认参数
+#define TM1639_IDLE_DIM_S 60   // 空闲多久后降亮度(s)
+#define TM1639_IDLE_OFF_S 600  // 空闲多久后切断显示电源(s)
+#define TM1639_DIM_LEVEL 1     // 降亮度后的亮度级别(1-8)
+#define TM1639_POWER_UP_MS 5   // 恢复供电后等待芯片就绪的时间(ms)
+
+// 显示功耗状态
+typedef enum
+{
+    TM1639_POWER_ACTIVE, // 正常亮度
+    TM1639_POWER_DIM,    // 降亮度
+    TM1639_POWER_OFF,    // 显示电源已切断
+} TM1639PowerState_e;
+
+// 显示能耗统计
 typedef struct
 {
-    TM1639KeyId_e    id;
-    GPIO_PinState current; // Current state (pressed/released)
-    GPIO_PinState last;
-    uint32_t press_time;    // Time of press
-    TM1639KeyState_e state;      // Key state
-    TM1639KeyState_e last_state; // Key state
-} TM1639key_t;
+    uint32_t dim_ms;   // 降亮度累计时间(ms)
+    uint32_t off_ms;   // 断电累计时间(ms)
+    uint32_t saved_ms; // 相对正常亮度节省的等效点亮时间(ms)，按占空比折算
+} TM1639PowerStat_t;
 
+// 跑马灯帧数
+#define TM1639_MARQUEE_FRAMES 14
+
+// 动画类型
+typedef enum
+{
+    TM1639_ANIM_NONE,
+    TM1639_ANIM_MARQUEE, // 跑马灯
+    TM1639_ANIM_ROLL,    // 单个显示位数值滚动
+    TM1639_ANIM_SCROLL,  // 字符串滚动
+} TM1639AnimType_e;
+
+// 动画状态
+typedef struct
+{
+    TM1639AnimType_e type;
+    uint16_t period;     // 帧周期(ms)
+    int8_t step;         // 帧推进方向 1/-1
+    uint8_t frame;       // 当前帧
+    uint8_t frame_count; // 总帧数
+    uint8_t pos;         // 滚动的显示位(ROLL)
+    const char *text;    // 滚动的字符串(SCROLL)
+    uint32_t due;        // 下次换帧时刻(tick)
+} TM1639Anim_t;
 
 
 void TM1639Clear(void);
+uint8_t TM1639Glyph(char letter);
+void TM1639Flush(void);
+const TM1639BusStat_t *GetTM1639BusStat(void);
 void TM1639NumShow(uint8_t nums[], uint8_t dots[], uint8_t start_pos, uint8_t length);
 void TM1639LetterShow(char texts[], uint8_t textLength, uint8_t dots[]);
 void TM1639RemixShow(char texts[], uint8_t textLength, uint8_t nums[], uint8_t numsLength, uint8_t dots[]);
 void TM1639SetBrightness(uint8_t brightness);
 void TM1639SetDisplayState(TM1639_Switch_e state); 
 void TM1639PowerCtrl(TM1639_Switch_e PinState);
+void TM1639GovernorConfig(uint16_t dim_s, uint16_t off_s);
+bool TM1639GovernorKick(void);
+bool TM1639GovernorTick(uint32_t *next);
+TM1639PowerState_e TM1639GetPowerState(void);
+const TM1639PowerStat_t *GetTM1639PowerStat(void);
 uint16_t TM1639_ReadKey(void);
 TM1639_KeyState_e parse_key_status(uint16_t key_value, uint8_t key_number);
 void TM1639Init(void);
-void TM1639KeyScan(void);
-void TM1639MsHandle(void);
-TM1639key_t *GetTM1639KeyInfo(void);
+bool TM1639KeyPoll(uint32_t *next);
+uint16_t TM1639GetKeyValue(void);
 void TM1639_Test(void);
 void MarqueeDisplay(uint8_t index_num);
+void TM1639BlinkSet(uint8_t mask, uint16_t period);
+void TM1639AnimMarquee(int8_t dir, uint16_t period);
+void TM1639AnimRoll(uint8_t pos, uint8_t max, uint16_t period);
+void TM1639AnimScroll(const char *text, uint16_t period);
+void TM1639AnimStop(void);
+TM1639AnimType_e TM1639AnimGetType(void);
+void TM1639AnimTick(void);
+bool TM1639AnimNextDue(uint32_t *next);
 
 #endif // _TM1639_H_
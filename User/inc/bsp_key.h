@@ -2,41 +2,48 @@
 #define _TEST_KEY_H_
 
 #include "main.h"
+#include "key_debounce.h"
 
 
 #define PRESEED GPIO_PIN_RESET
 #define RELEASED GPIO_PIN_SET
 
+// 统一按键编号：0-4为TM1639上的SW1-SW5(同TM1639KeyId_e)，5-6为GPIO按键
 typedef enum
 {
-    KEY_POWER,
-    KEY_TOUCH,
+    KEY_POWER = 5, // SW6 电源键
+    KEY_TOUCH,     // 触摸键
 } KeyId_e;
 
-typedef enum
+// 按键事件，类型取KEY_PRESSED/KEY_CLICKED/KEY_LONG_PRESSED/KEY_RELEASED/KEY_REPEAT
+typedef struct
 {
-    KEY_IDLE,
-    KEY_PRESSED,
-    KEY_RELEASED,
-    KEY_CLICKED,
-    KEY_LONG_PRESSED,
-    KEY_LONG_PRESSED_BACK
-} KeyState_e;
+    uint32_t tick;   // 事件时刻(tick)
+    uint8_t key;     // 统一按键编号
+    uint8_t type;    // 事件类型(KeyState_e)
+    uint8_t step;    // 步进，连发后期为10，其余为1
+} KeyEvent_t;
 
+// 触摸急停耗时统计
 typedef struct
 {
-    KeyId_e    id;
-    GPIO_TypeDef *port;
-    uint16_t pin;
-    GPIO_PinState current; // Current state (pressed/released)
-    GPIO_PinState last;
-    uint32_t press_time;    // Time of press
-    KeyState_e state;      // Key state
-    KeyState_e last_state; // Key state
-} key_t;
-
-
-void KeyScan(void);
-void KeyMsHandle(void);
+    uint32_t count;          // 触摸中断次数
+    uint32_t cut_cycles;     // 上次从进入回调到切断电机使能的CPU周期
+    uint32_t cut_cycles_max; // 最大切断耗时(CPU周期)
+    uint32_t pause_ms;       // 上次从触摸中断到控制台进入暂停的时间(ms)
+    uint32_t pause_ms_max;   // 最大暂停耗时(ms)
+} KeyTouchStat_t;
+
+// 按键事件缓冲深度(2的幂)
+#define KEY_EVENT_QUEUE_SIZE 8
+
+
+uint8_t KeyScan(void);
+bool KeyEventGet(KeyEvent_t *event);
+uint32_t KeyEventLost(void);
+uint8_t KeyIrqTake(uint32_t *touch_tick);
+uint8_t KeyIrqPending(void);
+void KeyTouchPauseDone(void);
+const KeyTouchStat_t *GetKeyTouchStat(void);
 const key_t *GetKeyInfo(void);
 #endif // _TEST_KEY_H_
@@ -0,0 +1,38 @@
+#ifndef _BSP_OPTO_H_
+#define _BSP_OPTO_H_
+
+#include "main.h"
+
+
+// 光耦编号
+typedef enum
+{
+    OPTO_ROTATE = 0, // 旋转定位光耦 rotateOptoKey(PA0)
+    OPTO_OUTPUT,     // 出牌光耦 outputOptoKey(PB2)
+} OptoId_e;
+
+#define NUM_OPTOS 2
+
+// 计数边沿：放开时刻和本次遮挡时长
+typedef struct
+{
+    uint32_t us;    // 放开时刻(us)
+    uint32_t width; // 遮挡时长(us)，分辨率 1<<OPTO_WIDTH_SHIFT
+} OptoEdge_t;
+
+#define OPTO_TIMER_HZ 1000000U        // TIM14 时基，1us
+#define OPTO_GLITCH_US 100U           // 遮挡时间短于此值的脉冲视为干扰
+#define OPTO_EDGE_QUEUE_SIZE 8        // 每路边沿缓冲长度，必须是2的幂
+#define OPTO_WIDTH_SHIFT 4            // 遮挡时长按16us存为16位，最长约1s
+
+void OptoInit(void);
+uint32_t OptoNowUs(void);
+bool OptoEdgeGet(OptoId_e opto, OptoEdge_t *edge);
+void OptoFlush(OptoId_e opto);
+uint32_t OptoEdgeLost(void);
+void OptoExtiIrq(uint16_t GPIO_Pin, GPIO_PinState level);
+void OptoTimerIrq(void);
+void OptoGuardSet(bool on);
+bool OptoGuardTripped(void);
+
+#endif /* _BSP_OPTO_H_ */
@@ -8,9 +8,10 @@
 #define MARQUEE_PERIOD    (80)
 #define BUZZER_TIME (100)
 #define BLINK_PERIOD (350)
+#define ROLL_PERIOD (60)
 // #define BUZZER_ENABLE   1
 
-#define FLASH_USER_START_ADDR   ((uint32_t)0x08007C17) /* 用户Flash区域起始地址 使用flash尾部1000字节的空间*/ 
+#define FLASH_USER_START_ADDR   ((uint32_t)0x08007800) /* 用户Flash区域起始地址 使用flash最后一页(2KB)，双字编程需8字节对齐*/
 #define FLASH_USER_END_ADDR     ((uint32_t)0x08007FFF) /* 用户Flash区域结束地址 */
 
 
@@ -29,7 +30,8 @@ typedef enum {
 // 定义发牌模式
 typedef enum {
     SWAY_DEAL,              // 左右摇摆发牌 
-    ROTATE_DEAL             // 单旋转发牌
+    ROTATE_DEAL,            // 单旋转发牌
+    SCRIPT_DEAL             // 按牌局脚本发牌，dealMode - SCRIPT_DEAL 为 deal_script 的编号
 } DealingMode_e;
 
 // 定义出牌顺序
@@ -49,7 +51,8 @@ typedef enum {
     NO_LAUNCH = 0,
     NORMAL_LAUNCH,      // 发牌
     RANDOM_LAUNCH,       // 随机发牌
-    TEST_LAUNCH        // 测试
+    TEST_LAUNCH,       // 测试
+    CALIBRATE_LAUNCH   // 座位标定：按请求点动转盘
 } LaunchMode_e;
 
 // 菜单项结构体
@@ -82,6 +85,7 @@ typedef enum
     SETTING_MODE,              // 设置模式  
     SAFETY_MODE,               // 安全模式
     CLOSE_MODE,                // 关机模式
+    CALIBRATE_MODE,            // 座位标定模式
 } CtrlMode_e;       // 运行模式
 
 
@@ -100,16 +104,6 @@ typedef struct
     uint16_t adBuff_value[30];
 }Console_t;
 
-typedef enum{
-    UNBLINK,
-    ENBLINK
-}Blink_e;
-
-typedef enum{
-    BLINK_OFF,
-    BLINK_ON
-}BlinkState_e;
-
 // 显示信息内容类型枚举
 typedef enum{
     NONE_CONTENT,      // 无内容
@@ -117,29 +111,28 @@ typedef enum{
     STRING_CONTENT,    // 字符串
     STRING_DIGITAL_CONTENT, // 字符串+数字
     MARQUEE_CONTENT,    // 跑马灯
+    ROLL_CONTENT,       // 数字+'位'滚动
 }DisplayContentType_e;
 
 typedef struct 
 {
-    bool needUpdate;
     DisplayContentType_e content_type;
-    Blink_e blink_en;
-    BlinkState_e blink_state;
-    uint8_t marQuee_index;
-    uint16_t marQuee_period;
+    uint8_t blink_mask;     // 闪烁的显示位(bit0为最左位)
+    int8_t marquee_dir;     // 跑马灯方向 1:顺时针 -1:逆时针
+    uint8_t roll_max;       // '位'滚动上限
     uint8_t digital_content[5];
     char string_content[5];
     uint8_t dot_content[5];
     uint8_t start_pos;
     uint8_t start_pos2;
     uint8_t length;
-    uint16_t blink_period;
 } DisplayInfo_t;
 
 
-extern DisplayInfo_t displayInfo;
 void ConsoleInit(void);
-void ConsoleModeSwitch(void);
+bool DisplayFetch(DisplayInfo_t *frame, uint32_t *version);
+void ConsoleModeSwitch(const KeyEvent_t *event);
+bool ConsoleKeyIrq(void);
 void ConsoleMsHandle(void);
 void WorkModeSwitch(void);
 
@@ -0,0 +1,74 @@
+#ifndef _DEAL_H_
+#define _DEAL_H_
+
+#include "main.h"
+#include "FreeRTOS.h"
+#include "motor.h"
+#include "console.h"
+#include "deal_script.h"
+#include "deal_plan.h"
+
+
+// 发牌步骤操作码
+typedef enum
+{
+    DEAL_OP_END = 0,    // 结束
+    DEAL_OP_HOME,       // 扇区号未确定时寻找原点槽
+    DEAL_OP_ROTATE,     // 转到扇区 arg，dir 为 MOTOR_STOP 时走较近的方向
+    DEAL_OP_STEP,       // 沿 dir 越过 arg 个光耦边沿
+    DEAL_OP_EJECT,      // 出 arg 张牌
+    DEAL_OP_DWELL,      // 距上次到位至少 arg*10ms 后继续
+    DEAL_OP_ROUND,      // 一轮结束，轮数已满时跳到 arg
+    DEAL_OP_LOOP,       // 跳到 arg
+    DEAL_OP_COUNT,      // 重新开始计轮，轮数为 arg
+    DEAL_OP_BURST,      // 连发 arg 张牌，最后一轮只出剩余的牌数
+    DEAL_OP_NUM
+} DealOp_e;
+
+// 发牌引擎状态
+typedef enum
+{
+    DEAL_IDLE = 0,      // 空闲，可以开始新计划
+    DEAL_RUN,           // 执行中
+    DEAL_PAUSE,         // 暂停，恢复后从当前步骤继续
+    DEAL_DONE,          // 计划执行完毕
+    DEAL_FAULT,         // 找不到原点槽或电机/出牌超时
+} DealState_e;
+
+// 发牌步骤，3字节
+typedef struct
+{
+    uint8_t op;         // DealOp_e
+    int8_t dir;         // MotorDirection_e
+    uint8_t arg;
+} DealStep_t;
+
+// 每种步骤的耗时统计(us)
+typedef struct
+{
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint32_t total_us;
+} DealStat_t;
+
+#define DEAL_PLAN_MAX 32        // 计划最多步数
+#define DEAL_STALL_MS 3000      // 转动/出牌超过此时间没有光耦边沿视为故障
+#define DEAL_DWELL_UNIT 10      // DEAL_OP_DWELL 的时间单位(ms)
+#define DEAL_PRESPIN_TIME 60    // 转盘到位前提前起动出牌电机的时间(ms)
+#define SWAY_DEAD_TIME 30       // 摆动发牌换向死区(ms)，在制动时间之后
+
+MotorDirection_e DealDirection(const MenuItem_t *menu);
+
+bool DealStart(const DealStep_t *step, uint8_t count, uint8_t rounds, MotorDirection_e dir);
+bool DealStartMenu(const MenuItem_t *menu);
+bool DealStartScript(const MenuItem_t *menu, const DealScript_t *script);
+void DealPause(void);
+void DealResume(void);
+void DealAbort(void);
+DealState_e DealGetState(void);
+uint32_t DealCards(void);
+const DealStat_t *DealGetStat(DealOp_e op);
+TickType_t DealRun(void);
+
+#endif // _DEAL_H_
@@ -0,0 +1,13 @@
+#ifndef _DEAL_PLAN_H_
+#define _DEAL_PLAN_H_
+
+#include <stdint.h>
+#include "motor_seat.h"
+
+uint8_t DealSectorGap(uint8_t from, uint8_t to, MotorDirection_e dir);
+MotorDirection_e DealSectorShortest(uint8_t from, uint8_t to, MotorDirection_e prefer);
+uint8_t DealSeatSector(uint8_t players, uint8_t seat);
+uint8_t DealSeatPlan(uint8_t players, MotorDirection_e dir, uint8_t heading, uint8_t order[SEAT_MAX]);
+uint8_t DealSwayPlan(uint8_t players, MotorDirection_e dir, uint8_t order[SEAT_MAX]);
+
+#endif // _DEAL_PLAN_H_
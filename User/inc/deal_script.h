@@ -0,0 +1,61 @@
+#ifndef _DEAL_SCRIPT_H_
+#define _DEAL_SCRIPT_H_
+
+#include <stdint.h>
+#include "motor_seat.h"
+
+
+// 发牌脚本操作码，每条指令2字节：操作码 + 参数
+typedef enum
+{
+    DS_OP_END = 0,          // 脚本结束
+    DS_OP_ROTATE_TO,        // 转到座位 arg(0起)，DS_SEAT_BASE 为底牌/公共牌位置
+    DS_OP_EJECT,            // 在当前位置出 arg 张牌
+    DS_OP_REPEAT,           // 以下到 DS_OP_NEXT 的指令重复 arg 次
+    DS_OP_FOR_EACH_SEAT,    // 以下到 DS_OP_NEXT 的指令在每个座位执行一次，按最短行程顺序转到各座位
+    DS_OP_NEXT,             // 块结束
+    DS_OP_BASE_PILE,        // 转到底牌位置出 arg 张牌
+    DS_OP_NUM
+} DealScriptOp_e;
+
+#define DS_SEAT_BASE 0xFFU      // DS_OP_ROTATE_TO 的底牌位置，座位间最大空档的中点
+#define DS_DEPTH_MAX 3          // 块嵌套层数上限
+
+// 编写脚本用的指令宏
+#define DS_END()            DS_OP_END, 0
+#define DS_ROTATE_TO(seat)  DS_OP_ROTATE_TO, (seat)
+#define DS_EJECT(n)         DS_OP_EJECT, (n)
+#define DS_REPEAT(n)        DS_OP_REPEAT, (n)
+#define DS_FOR_EACH_SEAT()  DS_OP_FOR_EACH_SEAT, 0
+#define DS_NEXT()           DS_OP_NEXT, 0
+#define DS_BASE_PILE(n)     DS_OP_BASE_PILE, (n)
+
+// 发牌脚本，存放在flash中
+typedef struct
+{
+    const uint8_t *code;    // 指令
+    uint8_t size;           // 指令字节数
+    uint8_t players;        // 玩家数，0 跟随菜单设置
+    uint8_t cards;          // 每个座位应得的牌数，校验用
+    uint8_t base;           // 底牌/公共牌数，校验用
+} DealScript_t;
+
+// 脚本校验结果
+typedef enum
+{
+    DS_OK = 0,
+    DS_ERR_OP,              // 未知操作码或缺少 DS_OP_END
+    DS_ERR_BLOCK,           // 块不配对或嵌套过深
+    DS_ERR_SEAT,            // 没有玩家、座位超出玩家数，或出牌前没有确定位置
+    DS_ERR_NEST,            // FOR_EACH_SEAT 块内不能再转动
+    DS_ERR_COUNT,           // 座位或底牌得到的牌数与声明不符
+} DealScriptErr_e;
+
+extern const DealScript_t deal_script[];
+extern const uint8_t deal_script_num;
+
+uint8_t DealScriptPlayers(const DealScript_t *script, uint8_t players);
+uint8_t DealScriptBlockEnd(const DealScript_t *script, uint8_t i);
+DealScriptErr_e DealScriptCheck(const DealScript_t *script, uint8_t players, uint16_t seat_cards[SEAT_MAX], uint16_t *base_cards);
+
+#endif // _DEAL_SCRIPT_H_
@@ -14,6 +14,9 @@ void FlashInit(void);
 // 写入数据到Flash
 HAL_StatusTypeDef FlashWrite(uint32_t address, uint32_t *data, uint32_t length);
 
+// 在已擦除的位置编程一个双字
+HAL_StatusTypeDef FlashProgramDword(uint32_t address, uint64_t dword);
+
 // 从Flash读取数据
 void FlashRead(uint32_t address, uint32_t *data, uint32_t length);
 
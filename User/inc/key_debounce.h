@@ -0,0 +1,66 @@
+#ifndef _KEY_DEBOUNCE_H_
+#define _KEY_DEBOUNCE_H_
+
+#include <stdint.h>
+
+// 按键消抖和单击/长按/连发判断，不依赖HAL和RTOS，输入为采样位图和时刻，可在主机上回放
+
+#define NUM_KEYS 7
+
+// 时刻单位为tick，与 configTICK_RATE_HZ 相同
+#define KEY_TICK_HZ 1000U
+#define KEY_MS_TO_TICKS(ms) ((uint32_t)(ms) * KEY_TICK_HZ / 1000U)
+
+#define KEY_LONG_PRESS_THRESHOLD 2000 // 长按时长
+#define KEY_CLICK_THRESHOLD 500       // 单击时长
+
+// 自动连发：按住超过首次延时后开始连发，间隔逐步缩短，按住更久后改为十位跳步
+#define KEY_REPEAT_MASK ((1U << 1) | (1U << 2)) // SW2/SW3(加/减)
+#define KEY_REPEAT_DELAY 500                    // 首次连发延时(ms)
+#define KEY_REPEAT_START 300                    // 初始连发间隔(ms)
+#define KEY_REPEAT_MIN 100                      // 最小连发间隔(ms)，每秒10次
+#define KEY_REPEAT_ACCEL 25                     // 每次连发间隔缩短(ms)
+#define KEY_REPEAT_DECADE 3000                  // 按住多久后改为十位跳步(ms)
+#define KEY_REPEAT_DECADE_INTERVAL 300          // 十位跳步间隔(ms)
+
+#define KEY_NO_REPEAT 0xFF
+
+typedef enum
+{
+    KEY_IDLE,
+    KEY_PRESSED,
+    KEY_RELEASED,
+    KEY_CLICKED,
+    KEY_LONG_PRESSED,
+    KEY_LONG_PRESSED_BACK,
+    KEY_REPEAT // 自动连发，只作为事件类型出现
+} KeyState_e;
+
+typedef struct
+{
+    uint32_t press_tick;   // 按下时刻(tick)
+    KeyState_e state;      // Key state
+    KeyState_e last_state; // Key state
+} key_t;
+
+// 消抖状态：全部按键打包成位图(bit n对应按键编号n)，用2位垂直计数器并行消抖
+typedef struct
+{
+    uint8_t vc_cnt0;
+    uint8_t vc_cnt1;
+    uint8_t down;               // 消抖后的按下位图
+    uint8_t busy;               // 状态不为KEY_IDLE的按键位图
+    key_t keys[NUM_KEYS];
+    uint8_t repeat_key;         // 自动连发的按键，同一时刻只有一个
+    uint16_t repeat_interval;   // 当前连发间隔(ms)
+    uint32_t repeat_due;        // 下次连发时刻(tick)
+} KeyDebounce_t;
+
+#define KEY_DEBOUNCE_INIT {0xFF, 0xFF, 0, 0, {{0, KEY_IDLE, KEY_IDLE}}, KEY_NO_REPEAT, KEY_REPEAT_START, 0}
+
+// 事件输出：按键编号、事件类型、时刻、步进
+typedef void (*KeyEventSink_t)(uint8_t key, KeyState_e type, uint32_t tick, uint8_t step);
+
+uint8_t KeyDebounceUpdate(KeyDebounce_t *kd, uint8_t sample, uint32_t now, KeyEventSink_t sink);
+
+#endif // _KEY_DEBOUNCE_H_
@@ -1,6 +1,7 @@
 #ifndef __MOTOR_H
 #define __MOTOR_H
 #include "main.h"
+#include "motor_seat.h"
 
 
 typedef enum {
@@ -9,10 +10,48 @@ typedef enum {
 } MotorId_e;
 
 typedef enum {
-    MOTOR_REVERSE = -1,       // 反转
-    MOTOR_STOP,               // 停止
-    MOTOR_FORWARD,            // 正转
-} MotorDirection_e;
+    MOTOR_RAMP_TRAPEZOID = 0, // 梯形(线性)加减速
+    MOTOR_RAMP_S_CURVE,       // S形(smoothstep)加减速，起止处加加速度为0
+} MotorRamp_e;
+
+typedef enum {
+    MOTOR_STOP_COAST = 0,     // 惰行：关使能，电机自由转动
+    MOTOR_STOP_BRAKE,         // 制动：FI=BI=1 两个下管短接绕组，保持到下次启动
+    MOTOR_STOP_BRAKE_COAST,   // 制动 brake_ms 后转惰行
+} MotorStopMode_e;
+
+// PWM频率，20kHz 在人耳范围之外
+#define MOTOR_PWM_HZ            20000U
+#define MOTOR_DUTY_FULL         1000U   // 占空比满量程(‰)
+
+// 出牌电机默认曲线：负载轻，快起快停
+#define MOTOR_OUT_MAX_DUTY      1000U
+#define MOTOR_OUT_MIN_DUTY      250U
+#define MOTOR_OUT_ACCEL_MS      60U
+#define MOTOR_OUT_DECEL_MS      40U
+#define MOTOR_OUT_BRAKE_MS      30U
+// 旋转电机默认曲线：转盘惯量大，S形平滑起停防止牌堆甩动
+#define MOTOR_ROTATE_MAX_DUTY   800U
+#define MOTOR_ROTATE_MIN_DUTY   200U
+#define MOTOR_ROTATE_ACCEL_MS   200U
+#define MOTOR_ROTATE_DECEL_MS   150U
+#define MOTOR_ROTATE_BRAKE_MS   120U
+
+// 预测停止：位置以相邻两个光耦边沿的间距为 MOTOR_PITCH，减速度单位为 Q8(MOTOR_PITCH/ms²)
+#define MOTOR_PITCH             65536U
+#define MOTOR_DECEL_DEFAULT     800U    // 约在1/4间距内停下(边沿周期200ms时)
+#define MOTOR_DECEL_MIN         16U
+#define MOTOR_SETTLE_MAX_MS     500U    // 断电后等待越过目标边沿的最长时间
+#define MOTOR_PERIOD_MIN_US     2000U   // 边沿间隔下限，限制速度估计不超出范围
+
+// 旋转里程：扇区数 ROTATE_SECTORS 见 motor_seat.h
+#define ROTATE_HOME_RATIO       384U    // 遮挡比例超过普通槽平均值的1.5倍(Q8)判为原点槽
+#define MOTOR_HEADING_VALID     0x80000000U
+
+#define MOTOR_PARAM_ADDR        ((uint32_t)0x08007000) /* 电机学习参数，flash倒数第二页 */
+#define MOTOR_PARAM_MAGIC       0x4D545034U
+#define MOTOR_HEADING_LOG_ADDR  (MOTOR_PARAM_ADDR + 0x40U)  /* 航向追加记录区，每条一个双字，写满才擦页 */
+#define MOTOR_HEADING_LOG_END   (MOTOR_PARAM_ADDR + 0x800U)
 
 // typedef enum{
 //     RUNNING_NORMAL,
@@ -20,15 +59,92 @@ typedef enum {
 //     RUNNING_ERROR,
 // } MotorRuning_e;
 
+typedef enum {
+    BRIDGE_COAST = 0,               // 桥臂全关
+    BRIDGE_RUN,                     // PWM输出
+    BRIDGE_BRAKE,                   // 下管短接制动
+} MotorBridge_e;
+
 typedef struct{
+    uint16_t max_duty;          // 正常运行占空比(‰)
+    uint16_t min_duty;          // 起动占空比(‰)，低于此值电机转不动，从停止起步直接跳到该值
+    uint16_t accel_ms;          // 0 → max_duty 的加速时间
+    uint16_t decel_ms;          // max_duty → 0 的减速时间
+    MotorRamp_e curve;          // 斜坡形状
+    uint16_t brake_ms;          // 定时制动的制动时间
+} MotorProfile_t;
+
+// 电机硬件描述：PWM所在定时器通道，方向/使能引脚
+typedef struct{
+    TIM_TypeDef *tim;               // PWM定时器
+    volatile uint32_t *ccr_fi;      // FI路比较寄存器，FI为GPIO时为NULL
+    volatile uint32_t *ccr_bi;      // BI路比较寄存器
+    volatile uint32_t *ccr_en;      // 使能路比较寄存器，使能为GPIO时为NULL
+    uint32_t ccmr_run;              // CCMR2：PWM模式
+    uint32_t ccmr_high;             // CCMR2：强制高电平
+    uint32_t ccmr_low;              // CCMR2：强制低电平
+    GPIO_TypeDef *fi_port;          // FI/BI 需在同一端口，方向由一次BSRR写入切换
+    uint16_t fi_pin;
+    uint16_t bi_pin;
+    GPIO_TypeDef *en_port;
+    uint16_t en_pin;
+} MotorHw_t;
+
+typedef struct Motor_s Motor_t;
+
+// 驱动操作，按桥接方式(方向脚PWM / 使能脚PWM)各一套
+typedef struct{
+    void (*set_duty)(Motor_t *motor, uint32_t ccr);                 // 按当前输出方向写比较值
+    void (*direction)(Motor_t *motor, MotorDirection_e direction);  // 设定方向并进入PWM输出
+    void (*brake)(Motor_t *motor);                                  // 下管短接制动
+    void (*coast)(Motor_t *motor);                                  // 全关惰行
+} MotorOps_t;
+
+// 运行状态记录，斜坡节拍和光耦边沿(可在中断中)更新
+typedef struct{
+    volatile MotorDirection_e direction;  // 当前输出方向
+    volatile MotorDirection_e travel;     // 最近一次通电的方向，断电滑行时的边沿按此方向计
+    volatile uint16_t duty;               // 当前输出占空比(‰)
+    volatile uint32_t runtime;            // 累计通电时间(ms)
+    volatile uint32_t edges;              // 光耦边沿累计数
+    volatile uint32_t edge_us;            // 最近一次边沿时刻(us)
+} MotorState_t;
+
+// 预测停止状态
+typedef struct{
+    uint32_t period;                // 最近两次边沿的间隔(us)，0 表示尚未测得
+    uint8_t edges;                  // 本次定位运动已见到的边沿数
+    uint32_t cut_us;                // 断电时刻(us)
+    uint32_t cut_speed;             // 断电时速度(MOTOR_PITCH/ms)
+    uint32_t cut_remain;            // 断电时距目标边沿的剩余距离
+} MotorPredict_t;
+
+struct Motor_s{
     MotorId_e id;               // 电机ID
     // MotorRuning_e state;
-    int16_t current_pos;        // 定位点
-    MotorDirection_e direction; // 旋转方向
+    int16_t current_pos;        // 定位点，旋转电机为当前扇区号 0 ~ ROTATE_SECTORS-1
+    MotorDirection_e direction; // 旋转方向(请求)
     uint16_t cards;             // 已发的牌数
     uint32_t totalCards;        // 总共发的牌数
-} Motor_t;
+    const MotorHw_t *hw;        // 硬件描述
+    const MotorOps_t *ops;      // 驱动操作
+    MotorProfile_t profile;     // 加减速曲线
+    MotorState_t state;         // 运行状态
+    // 以下为驱动内部状态：请求值由控制台写入，实际输出由1ms斜坡节拍推进
+    MotorDirection_e req_dir;   // 请求方向，与当前方向不同时先减速到0再换向
+    uint16_t target;            // 请求占空比(‰)
+    uint16_t ramp_from;         // 本段斜坡起点
+    uint16_t ramp_to;           // 本段斜坡终点
+    uint16_t ramp_t;            // 本段已走时间(ms)
+    uint16_t ramp_len;          // 本段总时间(ms)
+    MotorBridge_e bridge;       // 桥臂状态
+    uint16_t brake_left;        // 剩余制动时间(ms)
+    MotorPredict_t predict;     // 预测停止
+    bool homed;                 // 扇区号已由原点槽或保存的航向确定
+    uint16_t slot_ratio;        // 普通槽遮挡时长/边沿间隔的平均值(Q8)
+};
 
+extern Motor_t motor[2];
 
 void outMotorForward(Motor_t *motor);
 void outMotorBackward(Motor_t *motor);
@@ -36,4 +152,22 @@ void outMotorStop(Motor_t *motor);
 void rotateMotorForward(Motor_t *motor);
 void rotateMotorBackward(Motor_t *motor);
 void rotateMotorStop(Motor_t *motor);
+void MotorInit(void);
+void MotorSetProfile(MotorId_e id, const MotorProfile_t *profile);
+const MotorProfile_t *MotorGetProfile(MotorId_e id);
+void MotorSetSpeed(Motor_t *motor, MotorDirection_e direction, uint16_t duty);
+void MotorRampStop(Motor_t *motor);
+void MotorStop(Motor_t *motor, MotorStopMode_e mode);
+uint16_t MotorGetDuty(MotorId_e id);
+void MotorRampTick(void);
+void MotorEdge(Motor_t *motor, uint32_t us, uint32_t width);
+void MotorParamSave(void);
+void MotorHeadingSave(void);
+void MotorPredictStart(MotorId_e id);
+bool MotorPredictStopDue(MotorId_e id, uint32_t now_us);
+uint16_t MotorPredictSettleMs(MotorId_e id);
+void MotorPredictLearn(MotorId_e id, uint32_t now_us, bool crossed);
+void MotorEmergencyCut(void);
+void MotorCutRelease(void);
+bool MotorIsCut(void);
 #endif /* __MOTOR_H */
@@ -0,0 +1,23 @@
+#ifndef __MOTOR_SEAT_H
+#define __MOTOR_SEAT_H
+#include <stdint.h>
+
+// 转盘方向、扇区和座位定义，不依赖HAL，发牌规划和主机测试直接包含
+
+typedef enum {
+    MOTOR_REVERSE = -1,       // 反转
+    MOTOR_STOP,               // 停止
+    MOTOR_FORWARD,            // 正转
+} MotorDirection_e;
+
+// 旋转里程：每个光耦槽为一个扇区边界，0号槽(原点槽)比普通槽宽，扇区号从原点槽起沿正转方向递增
+#define ROTATE_SECTORS          12U     // 转盘一周的光耦槽数(含原点槽)，按结构修改
+
+// 座位标定表：每个座位记录所在扇区，座位可以不均匀分布
+#define SEAT_MAX                8U      // 最多玩家数，需为4的倍数(按字保存)
+#define SEAT_NONE               0xFFU
+
+void MotorSeatSet(const uint8_t *sector, uint8_t count);
+uint8_t MotorSeatGet(uint8_t count, uint8_t seat);
+
+#endif /* __MOTOR_SEAT_H */
@@ -0,0 +1,15 @@
+#ifndef _TM1639_DMA_H_
+#define _TM1639_DMA_H_
+#include "main.h"
+#include "tm1639_wave.h"
+
+// 波形步进频率，每一位占用两步(CLK低+DIO, CLK高)，总线时钟为步进频率的一半
+#define TM1639_DMA_STEP_HZ 2000000U
+
+extern DMA_HandleTypeDef hdma_tim16_up;
+
+void TM1639DmaInit(void);
+uint16_t TM1639DmaEncode(uint32_t *buf, const uint8_t *bytes, uint8_t length, uint8_t strobe_start, uint8_t strobe_end);
+void TM1639DmaWriteFrame(const uint8_t *bytes, uint8_t length);
+
+#endif // _TM1639_DMA_H_
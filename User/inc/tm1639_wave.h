@@ -0,0 +1,23 @@
+#ifndef _TM1639_WAVE_H_
+#define _TM1639_WAVE_H_
+#include <stdint.h>
+
+// TM1639 BSRR波形编码，不依赖HAL，可在主机上回放校验
+
+// 单次DMA传输最多携带的字节数，超过时分块发送，STB保持拉低
+#define TM1639_DMA_CHUNK_BYTES 4
+// 每块的BSRR字数：每字节16步 + STB拉低2步 + STB拉高3步
+#define TM1639_DMA_BUF_WORDS (TM1639_DMA_CHUNK_BYTES * 16 + 5)
+
+// 波形使用的引脚位(同一端口)
+typedef struct
+{
+    uint16_t clk;
+    uint16_t dio;
+    uint16_t stb;
+} TM1639WavePins_t;
+
+uint16_t TM1639WaveEncode(uint32_t *buf, const TM1639WavePins_t *pins, const uint8_t *bytes, uint8_t length,
+                          uint8_t strobe_start, uint8_t strobe_end);
+
+#endif // _TM1639_WAVE_H_
@@ -3,6 +3,7 @@
 
 /* 包含头文件 ----------------------------------------------------------------*/
 #include "main.h"
+#include "FreeRTOS.h"
 
 /* 类型定义 ------------------------------------------------------------------*/
 
@@ -11,5 +12,10 @@
 /* 扩展变量 ------------------------------------------------------------------*/
 
 /* 函数声明 ------------------------------------------------------------------*/
+void TM1639TaskNotify(void);
+void ConsoleTaskNotify(void);
+void ConsoleTaskNotifyFromISR(BaseType_t *woken);
+void DealTaskNotify(void);
+void DealTaskNotifyFromISR(BaseType_t *woken);
 
 #endif // USER_TASK_H
\ No newline at end of file
@@ -3,10 +3,15 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "log.h"
+#include <string.h>
+#if TM1639_PHY == TM1639_PHY_DMA
+#include "tm1639_dma.h"
+#endif
 
-#define NUM_TM1639KEYS 5                   
-#define KEY_LONG_PRESS_THRESHOLD 2000 // 长按时长
-#define KEY_CLICK_THRESHOLD 500       // 单击时长
+// 按键读取周期：有按键活动后保持快速扫描一段时间，空闲时降频以减少总线占用
+#define TM1639_KEY_SCAN_FAST 4     // 快速扫描周期(ms)
+#define TM1639_KEY_SCAN_SLOW 20    // 空闲扫描周期(ms)
+#define TM1639_KEY_ACTIVE_HOLD 2000 // 最后一次按键活动后保持快速扫描的时间(ms)
 
 // 操作单个位命令
 #define bitSet(value, bit) ((value) |= (1UL << (bit)))											// 设置位
@@ -15,110 +20,227 @@
 #define bitRead(value, bit) (((value) >> (bit)) & 0x01)											// 读取位状态
 #define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit)) // 根据bitvalue写入位状态
 
-// IO操作
-static inline void set_data_pin(GPIO_PinState state)
-{
-	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, state);
-}
-static inline void set_clk_pin(GPIO_PinState state)
-{
-	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_3, state);
-}
-static inline void set_strobe_pin(GPIO_PinState state)
-{	
-	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, state);
-}
-static inline GPIO_PinState get_data_pin()
-{
-	return HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_4);
-}
+// TM1639引脚(GPIOA)：PA3 CLK, PA4 DIO, PA5 STB
+#define TM1639_GPIO GPIOA
+#define TM1639_CLK GPIO_PIN_3
+#define TM1639_DIO GPIO_PIN_4
+#define TM1639_STB GPIO_PIN_5
+#define BSRR_SET(pins) ((uint32_t)(pins))
+#define BSRR_RESET(pins) ((uint32_t)(pins) << 16)
+
+// 总线时序：TM1639最高时钟1MHz，读键命令后需等待2us再读数据
+#define TM1639_CLK_HZ 1000000U
+#define TM1639_READ_WAIT_US 2U
+#define TM1639_DELAY_LOOP_CYCLES 4U // 每次延时循环的CPU周期数(SRAM执行，无等待周期)
+
+// 放在SRAM中执行，避免Flash等待周期影响总线时序(分散加载文件将.ramfunc段放入RW_IRAM1)
+#define TM1639_RAMFUNC __attribute__((section(".ramfunc"), noinline))
+
+// 置1时在初始化后对比HAL版本与寄存器版本的写字节耗时
+#ifndef TM1639_PHY_BENCH
+#define TM1639_PHY_BENCH 0
+#endif
 
 // 按键掩码，用于标识TM1639模块上不同按键的位置
-static uint16_t key_mask[5] = {12, 11, 16, 15, 4};
-uint8_t data[2] = {0};
+static const uint16_t key_mask[5] = {12, 11, 16, 15, 4};
 static uint16_t TM1639Key_Value = 0;
-static uint8_t start_hooking = 0;
-
-static TM1639key_t tm1639_keys[NUM_TM1639KEYS] = {
-    {TM1639KEY_RANDOM, 1, 1, 0, TM1639KEY_IDLE, TM1639KEY_IDLE},
-    {TM1639KEY_ADD, 1, 1, 0, TM1639KEY_IDLE, TM1639KEY_IDLE},
-	{TM1639KEY_SUB, 1, 1, 0, TM1639KEY_IDLE, TM1639KEY_IDLE},
-	{TM1639KEY_SETTING, 1, 1, 0, TM1639KEY_IDLE, TM1639KEY_IDLE},
-	{TM1639KEY_LAUNCH, 1, 1, 0, TM1639KEY_IDLE, TM1639KEY_IDLE},
-};
+static TickType_t key_due = 0;          // 下次读键时刻
+static TickType_t key_active_until = 0; // 快速扫描截止时刻
+static uint32_t half_clk_loops = 1;     // 半个时钟周期的延时循环数
+static uint32_t read_wait_loops = 1;    // 读键命令后的等待循环数
+
+// 显示寄存器影子缓存(C0H-CFH)，显示函数只渲染到缓存，由TM1639Flush统一下发
+static uint8_t tm1639_fb[TM1639_FB_SIZE] = {0};
+static uint8_t fb_dirty_start = TM1639_FB_SIZE; // 脏区起始地址(含)
+static uint8_t fb_dirty_end = 0;                 // 脏区结束地址(不含)
+static uint8_t disp_ctrl = 0x87;                 // 当前显示控制命令
+static uint8_t disp_ctrl_dirty = 0;              // 显示控制命令待下发
+static TM1639BusStat_t bus_stat = {0};
+
+// 动画引擎状态
+static TM1639Anim_t anim = {TM1639_ANIM_NONE};
+static uint8_t blink_mask = 0;     // 闪烁位掩码(bit0为最左位)
+static uint8_t blink_on = 1;       // 闪烁相位 1:显示 0:熄灭
+static uint16_t blink_period = 0;  // 闪烁半周期(ms)
+static TickType_t blink_due = 0;   // 下次翻转时刻
+
+// 显示功耗调节：空闲一段时间后降亮度，更久后切断显示电源
+static const uint8_t level_duty[8] = {1, 2, 4, 10, 11, 12, 13, 14}; // 各亮度级别的占空比(/16)
+static uint8_t active_level = 3;                       // 正常亮度级别(1-8)，默认4/16
+static uint16_t idle_dim_s = TM1639_IDLE_DIM_S;
+static uint16_t idle_off_s = TM1639_IDLE_OFF_S;
+static volatile TickType_t last_activity = 0;          // 最近一次按键或显示内容更新时刻
+static TM1639PowerState_e power_state = TM1639_POWER_ACTIVE;
+static TickType_t power_ready = 0;                     // 恢复供电后可访问总线的时刻
+static TickType_t power_account = 0;                   // 上次能耗统计时刻
+static TM1639PowerStat_t power_stat = {0};
+
 
 
 
 static uint16_t TM1639ReadKey(void);
+static bool TM1639BusReady(void);
 
 
 
 /**
- * @brief 设置数据引脚模式
+ * @brief 设置数据引脚方向，只改写PA4的MODER位
  *
- * @param mode GPIO_PIN_SET: 输出模式; GPIO_PIN_RESET: 输入模式
+ * @param output 1: 输出模式; 0: 输入模式(上拉在初始化时已配置)
  */
-static void set_data_pin_mode(GPIO_PinState mode)
+static inline void set_data_pin_mode(uint8_t output)
 {
-	GPIO_InitTypeDef GPIO_InitStruct = {0};
-	GPIO_InitStruct.Pin = GPIO_PIN_4;
-	GPIO_InitStruct.Mode = mode == GPIO_PIN_SET ? GPIO_MODE_OUTPUT_PP : GPIO_MODE_INPUT;
-	GPIO_InitStruct.Pull = GPIO_PULLUP;
-	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+	uint32_t moder = TM1639_GPIO->MODER & ~GPIO_MODER_MODE4;
+	TM1639_GPIO->MODER = output ? (moder | GPIO_MODER_MODE4_0) : moder;
 }
- 
-/**	
- * @brief TM1639延时函数
- * 使用hal库的延时函数代替nop延时
- * @param count 延时时间(count * 78.125 纳秒)
+
+/**
+ * @brief TM1639延时
+ *
+ * @param loops 循环次数(每次约TM1639_DELAY_LOOP_CYCLES个CPU周期)
  */
-void TM1639_Delay(uint8_t count)
+static TM1639_RAMFUNC void TM1639DelayLoops(uint32_t loops)
 {
-	for(uint8_t i=0;i < count; i++)
+	while (loops--)
 	{
 		__NOP();
-        __NOP();
-        __NOP();
-        __NOP();
-        __NOP();
 	}
 }
 
+/**
+ * @brief 获取当前CPU周期计数
+ * SysTick向下计数，结合系统节拍扩展为递增计数，仅用于总线耗时统计
+ * 节拍数和计数值分两次读取，前后两次读到的计数值变大说明中间发生了重装载，重新读取
+ * @return uint32_t 周期计数
+ */
+static uint32_t TM1639GetCycles(void)
+{
+	uint32_t reload = SysTick->LOAD + 1;
+	uint32_t val, tick;
+
+	do
+	{
+		val = SysTick->VAL;
+		tick = xTaskGetTickCount();
+	} while (SysTick->VAL > val);
+	return tick * reload + (reload - 1 - val);
+}
+
 /**
  * @brief 写一字节数据
- *
+ * 时钟下降沿与数据位用同一次BSRR写入，上升沿时数据已稳定半个周期
  * @param data 数据
  */
-static void TM1639WriteByte(uint8_t data)
+static TM1639_RAMFUNC void TM1639WriteByte(uint8_t data)
 {
-	start_hooking = 0;
+	uint32_t loops = half_clk_loops;
+
 	// 逐位发送数据，从最低位开始
 	for (uint8_t i = 0; i < 8; i++)
 	{
-		set_clk_pin(0);			// 时钟线拉低，准备数据发送
-		set_data_pin(data & 1); // 设置数据引脚
-		data >>= 1;				// 移位准备发送下一位
-		set_clk_pin(1);			// 时钟线拉高，完成这一位数据的发送
-		TM1639_Delay(1);
+		TM1639_GPIO->BSRR = BSRR_RESET(TM1639_CLK) | ((data & 1) ? BSRR_SET(TM1639_DIO) : BSRR_RESET(TM1639_DIO));
+		data >>= 1;
+		TM1639DelayLoops(loops);
+		TM1639_GPIO->BSRR = BSRR_SET(TM1639_CLK);
+		TM1639DelayLoops(loops);
 	}
-	start_hooking = 1;
 }
 
+/**
+ * @brief 读取16位按键数据，从最低位开始
+ *
+ * @return uint16_t 第一个字节在低8位
+ */
+static TM1639_RAMFUNC uint16_t TM1639ReadBits(void)
+{
+	uint32_t loops = half_clk_loops;
+	uint16_t bits = 0;
+
+	for (uint8_t i = 0; i < 16; i++)
+	{
+		TM1639_GPIO->BSRR = BSRR_RESET(TM1639_CLK);
+		TM1639DelayLoops(loops);
+		if (TM1639_GPIO->IDR & TM1639_DIO)
+		{
+			bits |= (1U << i);
+		}
+		TM1639_GPIO->BSRR = BSRR_SET(TM1639_CLK);
+		TM1639DelayLoops(loops);
+	}
+	return bits;
+}
 
+#if TM1639_PHY_BENCH
 /**
- * @brief 发送数据
+ * @brief 原HAL版本写字节，仅作为基准测试的对照
  *
- * @param address 地址
  * @param data 数据
  */
-static void TM1639WriteData(uint8_t address, uint8_t data)
+static void TM1639WriteByteHal(uint8_t data)
+{
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		HAL_GPIO_WritePin(GPIOA, TM1639_CLK, GPIO_PIN_RESET);
+		HAL_GPIO_WritePin(GPIOA, TM1639_DIO, (GPIO_PinState)(data & 1));
+		data >>= 1;
+		HAL_GPIO_WritePin(GPIOA, TM1639_CLK, GPIO_PIN_SET);
+		for (uint8_t n = 0; n < 5; n++)
+		{
+			__NOP();
+		}
+	}
+}
+
+/**
+ * @brief 测量HAL版本与寄存器版本每字节的CPU周期数，结果输出到日志
+ * 发送的是数据命令0x40，不改变显示内容
+ */
+static void TM1639PhyBenchmark(void)
+{
+	const uint8_t rounds = 32;
+	uint32_t hal_cycles = 0;
+	uint32_t reg_cycles = 0;
+	uint32_t start = 0;
+
+	TM1639_GPIO->BSRR = BSRR_RESET(TM1639_STB);
+	start = TM1639GetCycles();
+	for (uint8_t i = 0; i < rounds; i++)
+	{
+		TM1639WriteByteHal(0x40);
+	}
+	hal_cycles = TM1639GetCycles() - start;
+
+	start = TM1639GetCycles();
+	for (uint8_t i = 0; i < rounds; i++)
+	{
+		TM1639WriteByte(0x40);
+	}
+	reg_cycles = TM1639GetCycles() - start;
+	TM1639_GPIO->BSRR = BSRR_SET(TM1639_STB);
+
+	LOG_INFO("TM1639 PHY cycles/byte: HAL %u, register %u.\n", (unsigned int)(hal_cycles / rounds), (unsigned int)(reg_cycles / rounds));
+}
+#endif
+
+/**
+ * @brief 在一个STB窗口内发送一帧数据
+ *
+ * @param bytes 数据
+ * @param length 字节数
+ */
+static void TM1639WriteFrame(const uint8_t *bytes, uint8_t length)
 {
-	start_hooking = 0;
-	set_strobe_pin(0);
-	TM1639WriteByte(0x00 | address);
-	TM1639WriteByte(data);
-	set_strobe_pin(1);
-	start_hooking = 1;
+#if TM1639_PHY == TM1639_PHY_DMA
+	TM1639DmaWriteFrame(bytes, length);
+#else
+	TM1639_GPIO->BSRR = BSRR_RESET(TM1639_STB);
+	for (uint8_t i = 0; i < length; i++)
+	{
+		TM1639WriteByte(bytes[i]);
+	}
+	TM1639_GPIO->BSRR = BSRR_SET(TM1639_STB);
+	TM1639DelayLoops(half_clk_loops * 2); // STB高电平至少1us
+#endif
 }
 
 /**
@@ -145,9 +267,7 @@ static void TM1639WriteData(uint8_t address, uint8_t data)
  */
 static void TM1639WriteCmd(uint8_t cmd)
 {
-	set_strobe_pin(0);
-	TM1639WriteByte(cmd);
-	set_strobe_pin(1);
+	TM1639WriteFrame(&cmd, 1);
 }
 
 /**
@@ -157,126 +277,276 @@ static void TM1639WriteCmd(uint8_t cmd)
  */
 void TM1639Clear(void)
 {
-	set_strobe_pin(0);
-	TM1639WriteCmd(0xC0); // 设置数据地址
-	for (int i = 0; i < 16; i++)
+	memset(tm1639_fb, 0, sizeof(tm1639_fb));
+	fb_dirty_start = 0;
+	fb_dirty_end = TM1639_FB_SIZE;
+	TM1639Flush();
+}
+
+/**
+ * @brief 写入一个硬件位的段码到缓存
+ * 每一位占用两个地址，低4位在偶地址，高4位在奇地址
+ * @param hw_pos 硬件位置 0-4
+ * @param code 段码
+ */
+static void TM1639FbSetRaw(uint8_t hw_pos, uint8_t code)
+{
+	uint8_t addr = hw_pos * 2;
+	uint8_t low = code & 0x0F;
+	uint8_t high = code >> 4;
+
+	if (tm1639_fb[addr] == low && tm1639_fb[addr + 1] == high)
+	{
+		return;
+	}
+	tm1639_fb[addr] = low;
+	tm1639_fb[addr + 1] = high;
+	if (addr < fb_dirty_start)
+	{
+		fb_dirty_start = addr;
+	}
+	if (addr + 2 > fb_dirty_end)
 	{
-		TM1639WriteByte(0x00); // 清除所有LED
+		fb_dirty_end = addr + 2;
 	}
-	set_strobe_pin(1);
 }
 
 /**
- * @brief 获取数字编码
+ * @brief 写入一个显示位的段码到缓存
+ * @param pos 显示位置 0-4(从左到右)
+ * @param code 段码
+ */
+static void TM1639FbSetDigit(uint8_t pos, uint8_t code)
+{
+	// MARK: 3和4的位置调整以符合硬件位置
+	TM1639FbSetRaw((pos == 3) ? 4 : (pos == 4) ? 3 : pos, code);
+}
+
+/**
+ * @brief 读取一个显示位当前缓存的段码
+ * @param pos 显示位置 0-4(从左到右)
+ * @return uint8_t 段码
+ */
+static uint8_t TM1639FbGetDigit(uint8_t pos)
+{
+	uint8_t addr = ((pos == 3) ? 4 : (pos == 4) ? 3 : pos) * 2;
+	return tm1639_fb[addr] | (tm1639_fb[addr + 1] << 4);
+}
+
+/**
+ * @brief 显示位掩码转换为硬件位掩码
+ * @param mask 显示位掩码(bit0为最左位)
+ * @return uint8_t 硬件位掩码
+ */
+static uint8_t TM1639HwMask(uint8_t mask)
+{
+	// MARK: 3和4的位置调整以符合硬件位置
+	return (mask & 0x07) | ((mask & 0x08) << 1) | ((mask & 0x10) >> 1);
+}
+
+/**
+ * @brief 把指定硬件位标记为需要刷新
+ * @param hw_mask 硬件位掩码
+ */
+static void TM1639FbMarkDirty(uint8_t hw_mask)
+{
+	for (uint8_t i = 0; i < 5; i++)
+	{
+		if (hw_mask & (1 << i))
+		{
+			if (i * 2 < fb_dirty_start)
+			{
+				fb_dirty_start = i * 2;
+			}
+			if (i * 2 + 2 > fb_dirty_end)
+			{
+				fb_dirty_end = i * 2 + 2;
+			}
+		}
+	}
+}
+
+/**
+ * @brief 设置显示控制命令，在下次刷新时下发
+ * @param ctrl 显示控制命令
+ */
+static void TM1639FbSetCtrl(uint8_t ctrl)
+{
+	if (disp_ctrl != ctrl)
+	{
+		disp_ctrl = ctrl;
+		disp_ctrl_dirty = 1;
+	}
+}
+
+/**
+ * @brief 把缓存中的脏区一次性刷新到TM1639
+ * 使用地址自动增加模式：0x40 + (0xC0 | 起始地址) + N字节，只占用一个STB窗口
+ */
+void TM1639Flush(void)
+{
+	uint32_t start_cycles = 0;
+	uint8_t frame_bytes = 0;
+	uint8_t frame[TM1639_FB_SIZE + 1];
+	uint8_t length = 0;
+	uint8_t hw_blank = blink_on ? 0 : TM1639HwMask(blink_mask); // 闪烁熄灭相位时需要消隐的硬件位
+
+	if ((fb_dirty_start >= fb_dirty_end && !disp_ctrl_dirty) || !TM1639BusReady())
+	{
+		return;
+	}
+
+	start_cycles = TM1639GetCycles();
+	if (fb_dirty_start < fb_dirty_end)
+	{
+		TM1639WriteCmd(0x40); // 写数据到显示寄存器,自动地址增加
+		frame[length++] = 0xC0 | fb_dirty_start; // 设置起始地址
+		for (uint8_t addr = fb_dirty_start; addr < fb_dirty_end; addr++)
+		{
+			frame[length++] = (hw_blank & (1 << (addr / 2))) ? 0x00 : tm1639_fb[addr];
+		}
+		TM1639WriteFrame(frame, length);
+		frame_bytes += 1 + length;
+		fb_dirty_start = TM1639_FB_SIZE;
+		fb_dirty_end = 0;
+	}
+	if (disp_ctrl_dirty)
+	{
+		TM1639WriteCmd(disp_ctrl);
+		disp_ctrl_dirty = 0;
+		frame_bytes += 1;
+	}
+
+	bus_stat.frames++;
+	bus_stat.last_bytes = frame_bytes;
+	bus_stat.last_cycles = TM1639GetCycles() - start_cycles;
+	bus_stat.total_cycles += bus_stat.last_cycles;
+	if (bus_stat.last_cycles > bus_stat.max_cycles)
+	{
+		bus_stat.max_cycles = bus_stat.last_cycles;
+	}
+}
+
+/**
+ * @brief 获取显示刷新的总线耗时统计
+ * @return const TM1639BusStat_t* 统计信息
+ */
+const TM1639BusStat_t *GetTM1639BusStat(void)
+{
+	return &bus_stat;
+}
+
+/**
+ * ASCII到7段码的字库(存放在flash)
+ * 只列出可显示的字符，其余为0，由 TM1639Glyph 把未定义的可打印字符换成备用字形
+ * K,M,N,V,W,X等无法在7段上准确显示的字符使用备用字形，R,T仿照但不完美
+ */
+static const uint8_t tm1639_font[128] = {
+	['-'] = SEG_G,
+	['0'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_E|SEG_F,
+	['1'] = SEG_B|SEG_C,
+	['2'] = SEG_A|SEG_B|SEG_D|SEG_E|SEG_G,
+	['3'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_G,
+	['4'] = SEG_B|SEG_C|SEG_F|SEG_G,
+	['5'] = SEG_A|SEG_C|SEG_D|SEG_F|SEG_G,
+	['6'] = SEG_A|SEG_C|SEG_D|SEG_E|SEG_F|SEG_G,
+	['7'] = SEG_A|SEG_B|SEG_C,
+	['8'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_E|SEG_F|SEG_G,
+	['9'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_F|SEG_G,
+	['='] = SEG_D|SEG_G,
+	['A'] = SEG_A|SEG_B|SEG_C|SEG_E|SEG_F|SEG_G,
+	['B'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_E|SEG_F|SEG_G,
+	['C'] = SEG_A|SEG_D|SEG_E|SEG_F,
+	['D'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_E|SEG_F,
+	['E'] = SEG_A|SEG_D|SEG_E|SEG_F|SEG_G,
+	['F'] = SEG_A|SEG_E|SEG_F|SEG_G,
+	['G'] = SEG_B|SEG_C|SEG_D|SEG_E|SEG_G,
+	['H'] = SEG_B|SEG_C|SEG_E|SEG_F|SEG_G,
+	['I'] = SEG_B|SEG_C,
+	['J'] = SEG_B|SEG_C|SEG_D|SEG_E,
+	['L'] = SEG_D|SEG_E|SEG_F,
+	['O'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_E|SEG_F,
+	['P'] = SEG_A|SEG_B|SEG_E|SEG_F|SEG_G,
+	['Q'] = SEG_A|SEG_B|SEG_C|SEG_F|SEG_G,
+	['R'] = SEG_A|SEG_B|SEG_E|SEG_F,
+	['S'] = SEG_A|SEG_C|SEG_D|SEG_F|SEG_G,
+	['T'] = SEG_A|SEG_E|SEG_F,
+	['U'] = SEG_B|SEG_C|SEG_D|SEG_E|SEG_F,
+	['Y'] = SEG_B|SEG_C|SEG_D|SEG_F|SEG_G,
+	['_'] = SEG_D,
+	['a'] = SEG_A|SEG_B|SEG_C|SEG_E|SEG_F|SEG_G,
+	['b'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_E|SEG_F|SEG_G,
+	['c'] = SEG_D|SEG_E|SEG_G,
+	['d'] = SEG_B|SEG_C|SEG_D|SEG_E|SEG_G,
+	['e'] = SEG_A|SEG_D|SEG_E|SEG_F|SEG_G,
+	['f'] = SEG_A|SEG_B|SEG_C|SEG_G,
+	['g'] = SEG_B|SEG_C|SEG_D|SEG_E|SEG_G,
+	['h'] = SEG_B|SEG_C|SEG_E|SEG_F|SEG_G,
+	['i'] = SEG_B|SEG_C,
+	['j'] = SEG_B|SEG_C|SEG_D|SEG_E,
+	['l'] = SEG_D|SEG_E|SEG_F,
+	['o'] = SEG_A|SEG_B|SEG_C|SEG_D|SEG_E|SEG_F,
+	['p'] = SEG_A|SEG_B|SEG_E|SEG_F|SEG_G,
+	['q'] = SEG_A|SEG_B|SEG_C|SEG_F|SEG_G,
+	['r'] = SEG_A|SEG_B|SEG_E|SEG_F,
+	['s'] = SEG_A|SEG_C|SEG_D|SEG_F|SEG_G,
+	['t'] = SEG_A|SEG_E|SEG_F,
+	['u'] = SEG_B|SEG_C|SEG_D|SEG_E|SEG_F,
+	['y'] = SEG_B|SEG_C|SEG_D|SEG_F|SEG_G,
+};
+
+/**
+ * @brief 获取字符的7段编码
  *
- * @param num 数字
- * @return uint8_t 数字编码
+ * 控制字符和空格显示为空白，字库中没有的可打印字符显示为备用字形
+ * @param letter 字符
+ * @return uint8_t 段码(不含小数点)
  */
-static uint8_t getDigitCode(uint8_t num)
+uint8_t TM1639Glyph(char letter)
 {
-	const uint8_t digitCode[] = {
-		0x3F, // 0
-		0x06, // 1
-		0x5B, // 2
-		0x4F, // 3
-		0x66, // 4
-		0x6D, // 5
-		0x7D, // 6
-		0x07, // 7
-		0x7F, // 8
-		0x6F, // 9
-		0x00, // 10（不显示）
-	};
-	return digitCode[num];
+	uint8_t c = (uint8_t)letter;
+
+	if (c >= sizeof(tm1639_font))
+	{
+		return TM1639_GLYPH_FALLBACK;
+	}
+	if (tm1639_font[c] == 0 && c > ' ' && c < 0x7F)
+	{
+		return TM1639_GLYPH_FALLBACK;
+	}
+	return tm1639_font[c];
 }
 
 /**
- * @brief 获取字母编码
+ * @brief 获取数字编码
  *
- * @param letter 字母
+ * @param num 数字 0-9，其它值不显示
  * @return uint8_t 数字编码
  */
-static uint8_t getLetterCode(char letter)
+static inline uint8_t getDigitCode(uint8_t num)
 {
-	uint8_t index = 0;
-    // 大写字母编码
-    const uint8_t letterToSegmentUpperCase[26] = {
-        0x77, // A
-        0x7F, // B
-        0x27, // C
-        0x3F, // D
-        0x79, // E
-        0x71, // F
-        0x5E, // G
-        0x76, // H
-        0x06, // I
-        0x1E, // J
-        0x80, // K无法准确显示
-		0x38, // L
-		0x80, // M无法准确显示
-		0x80, // N无法准确显示
-		0x3F, // O
-		0x73, // P
-		0x67, // Q
-		0x33, // R, 仿照但不完美
-		0x6D, // S
-		0x31, // T, 仿照但不完美
-		0x3E, // U
-		0x80, // V无法准确显示
-		0x80, // W无法准确显示
-		0x80, // X无法准确显示
-		0x6E, // Y
-		0x00  // Z 不显示
-	};
-
-	// 小写字母编码（示例，可以根据实际情况修改）
-    const uint8_t letterToSegmentLowerCase[26] = {
-        0x77, // a
-        0x7F, // b
-        0x27, // c
-        0x5E, // d
-        0x79, // e
-        0x47, // f
-        0x5E, // g
-        0x76, // h
-        0x06, // i
-        0x1E, // j
-        0x80, // k无法准确显示
-		0x38, // l
-		0x80, // m无法准确显示
-		0x80, // n无法准确显示
-		0x3F, // o
-		0x73, // p
-		0x67, // q
-		0x33, // r, 仿照但不完美
-		0x6D, // s
-		0x31, // t, 仿照但不完美
-		0x3E, // u
-		0x80, // v无法准确显示
-		0x80, // w无法准确显示
-		0x80, // x无法准确显示
-		0x6E, // y
-		0x00  // z不显示
-    };
-
-	if (letter >= 'A' && letter <= 'Z') {
-        index = letter - 'A';
-        return letterToSegmentUpperCase[index];
-    }
-    else if (letter >= 'a' && letter <= 'z') {
-        index = letter - 'a';
-        return letterToSegmentLowerCase[index];
-    }
-    else if (letter == '-') {
-        return 0x40; // “-”的编码
-    }
-    else {
-        // 不是字母
-        return 0;
-    }
+	return tm1639_font[(num < 10) ? ('0' + num) : ' '];
 }
 
 
+// 跑马灯帧表，每帧为5个显示位(从左到右)的段码，逆时针方向时倒序播放
+static const uint8_t marquee_frames[TM1639_MARQUEE_FRAMES][5] = {
+	{0x01, 0x01, 0x01, 0x01, 0x00},
+	{0x00, 0x01, 0x01, 0x01, 0x01},
+	{0x00, 0x00, 0x01, 0x01, 0x03},
+	{0x00, 0x00, 0x00, 0x01, 0x07},
+	{0x00, 0x00, 0x00, 0x00, 0x0F},
+	{0x00, 0x00, 0x00, 0x08, 0x0E},
+	{0x00, 0x00, 0x08, 0x08, 0x0C},
+	{0x00, 0x08, 0x08, 0x08, 0x08},
+	{0x08, 0x08, 0x08, 0x08, 0x00},
+	{0x18, 0x08, 0x08, 0x00, 0x00},
+	{0x38, 0x08, 0x00, 0x00, 0x00},
+	{0x39, 0x00, 0x00, 0x00, 0x00},
+	{0x31, 0x01, 0x00, 0x00, 0x00},
+	{0x21, 0x01, 0x01, 0x00, 0x00},
+};
+
 /**
  * @brief 跑马灯显示
  * @param index_num 索引 0-13
@@ -285,37 +555,10 @@ static uint8_t getLetterCode(char letter)
 */
 void MarqueeDisplay(uint8_t index_num) 
 {
-	const uint8_t pos_base = 0xC0;	// 基址
-
-	uint8_t origin[5] = {0, 1, 2, 4, 3};	
-	uint8_t index[14][4] = {{0, 1, 2, 4}, {1, 2, 4, 3}, {2, 4, 3, 3}, {4, 3, 3, 3}, {3, 3, 3, 3}, {3, 3, 3, 4}, {3, 3, 4, 2}, 
-							{3, 4, 2, 1}, {4, 2, 1, 0}, {2, 1, 0, 0}, {1, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 1}, {0, 0, 1, 2}};
-	uint8_t pattern[14][4] = {{0x01, 0x01, 0x01, 0x01}, {0x01, 0x01, 0x01, 0x01}, {0x01, 0x01, 0x03, 0x03}, {0x01, 0x07, 0x07, 0x07},
-							{0x0F, 0x0F, 0x0F, 0x0F}, {0x0E, 0x0E, 0x0E, 0x08}, {0x0C, 0x0C, 0x08, 0x08}, {0x08, 0x08, 0x08, 0x08},
-							{0x08, 0x08, 0x08, 0x08}, {0x08, 0x08, 0x18, 0x18}, {0x08, 0x38, 0x38, 0x38}, {0x39, 0x39, 0x39, 0x39},	
-							{0x31, 0x31, 0x31, 0x01}, {0x21, 0x21, 0x01, 0x01}};
 	for (uint8_t i = 0; i < 5; i++)
-	{	
-		for(uint8_t j = 0; j < 4;j++)
-		{
-			if(origin[i] == index[index_num][j])
-			{	
-				break;
-			}
-			if(j == 3)
-			{
-				TM1639WriteData(pos_base + origin[i] * 2, 0x00 & 0x0F);
-        		TM1639WriteData(pos_base + origin[i] * 2 + 1, 0x00 >> 4);
-			}
-		}
-	}
-	
-    for (uint8_t i = 0; i < 4; i++) 	
 	{
-        TM1639WriteData(pos_base + index[index_num][i] * 2, pattern[index_num][i] & 0x0F);
-        TM1639WriteData(pos_base + index[index_num][i] * 2 + 1, pattern[index_num][i] >> 4);
-    }
-    TM1639WriteCmd(0x40); // 写数据到显示寄存器,自动地址增加
+		TM1639FbSetDigit(i, marquee_frames[index_num % TM1639_MARQUEE_FRAMES][i]);
+	}
 }
 
 /**
@@ -328,25 +571,15 @@ void MarqueeDisplay(uint8_t index_num)
  */
 void TM1639NumShow(uint8_t nums[], uint8_t dots[], uint8_t start_pos, uint8_t length)
 {
-	const uint8_t pos_base = 0xC0; // 命令字节的基地址
-	uint8_t index = start_pos;
+	uint8_t index = 0;
 
-	// 填充数字编码并发送	
+	// 填充数字编码到缓存
 	for (uint8_t i = start_pos; i < (start_pos + length); i++)
 	{
 		index = i - start_pos;
 		// 获取数字编码并设置小数点
-		uint8_t data = getDigitCode(nums[index]) | (dots[index] ? 0x80 : 0x00);
-		// MARK: 3和4的位置调整以符合硬件位置
-		index = (i == 3) ? 4 : (i == 4) ? 3 : i;
-		// 发送数字编码到TM1639	
-		TM1639WriteData(pos_base + index * 2, data & 0x0F);   // 发送低4位
-		TM1639WriteData(pos_base + index * 2 + 1, data >> 4); // 发送高4位
+		TM1639FbSetDigit(i, getDigitCode(nums[index]) | (dots[index] ? 0x80 : 0x00));
 	}
-
-	// 更新显示命令，以应用显示内容和亮度设置
-	TM1639WriteCmd(0x40); // 写数据到显示寄存器,自动地址增加
-	TM1639WriteCmd(0x8A); // 显示控制,设置脉冲宽度为4/16
 }
 
 /**
@@ -358,26 +591,12 @@ void TM1639NumShow(uint8_t nums[], uint8_t dots[], uint8_t start_pos, uint8_t le
  */
 void TM1639LetterShow(char texts[], uint8_t length, uint8_t dots[])
 {	
-	const uint8_t pos_base = 0xC0; // 命令字节的基地址
-	uint8_t index = 0;
-
-	// 填充字母编码并发送
+	// 填充字母编码到缓存
 	for (uint8_t i = 0; i < length; i++)
 	{
-		// MARK: 3和4的位置调整以符合硬件位置
-		index = (i == 3) ? 4 : (i == 4) ? 3 : i;
-
-		// 获取数字编码并设置小数点
-		uint8_t data = getLetterCode(texts[index]) | (dots[index] ? 0x80 : 0x00); 
-
-		// 发送数字编码到TM1639
-		TM1639WriteData(pos_base + i * 2, data & 0x0F);   // 发送低4位
-		TM1639WriteData(pos_base + i * 2 + 1, data >> 4); // 发送高4位
+		// 获取字母编码并设置小数点
+		TM1639FbSetDigit(i, TM1639Glyph(texts[i]) | (dots[i] ? 0x80 : 0x00));
 	}
-
-	// 更新显示命令，以应用显示内容和亮度设置
-	TM1639WriteCmd(0x40); // 写数据到显示寄存器,自动地址增加
-	TM1639WriteCmd(0x8A); // 显示控制,设置脉冲宽度为4/16
 }
 
 
@@ -393,45 +612,207 @@ void TM1639LetterShow(char texts[], uint8_t length, uint8_t dots[])
  */
 void TM1639RemixShow(char texts[], uint8_t textLength, uint8_t nums[], uint8_t numsLength, uint8_t dots[])
 {
-	const uint8_t pos_base = 0xC0; // 命令字节的基地址
 	uint8_t index = 0;
 
-	// 填充字母编码并发送
+	// 填充字母编码到缓存
 	for (uint8_t i = 0; i < textLength; i++)
 	{
-		// MARK: 3和4的位置调整以符合硬件位置
-		index = (i == 3) ? 4 : (i == 4) ? 3 : i;
-
-		// 获取数字编码并设置小数点
-		uint8_t data = getLetterCode(texts[index]) | (dots[index] ? 0x80 : 0x00);
-
-		// 发送数字编码到TM1639
-		TM1639WriteData(pos_base + index * 2, data & 0x0F);   // 发送低4位
-		TM1639WriteData(pos_base + index * 2 + 1, data >> 4); // 发送高4位
+		TM1639FbSetDigit(i, TM1639Glyph(texts[i]) | (dots[i] ? 0x80 : 0x00));
 	}
 
-	// 填充数字编码并发送
+	// 填充数字编码到缓存
 	for (uint8_t i = textLength; i < textLength + numsLength; i++)
 	{
-		// MARK: 3和4的位置调整以符合硬件位置
 		index = i - textLength;
-		// 获取数字编码并设置小数点
-		uint8_t data = getDigitCode(nums[index]) | (dots[index] ? 0x80 : 0x00);
-		index += textLength;
-		index = (index == 3) ? 4 : (index == 4) ? 3 : index;
-		// 发送数字编码到TM1639
-		TM1639WriteData(pos_base + index * 2, data & 0x0F);   // 发送低4位
-		TM1639WriteData(pos_base + index * 2 + 1, data >> 4); // 发送高4位
+		TM1639FbSetDigit(i, getDigitCode(nums[index]) | (dots[index] ? 0x80 : 0x00));
 	}
+}
 
-	// 更新显示命令，以应用显示内容和亮度设置
-	TM1639WriteCmd(0x40); // 写数据到显示寄存器,自动地址增加
-	TM1639WriteCmd(0x8A); // 显示控制,设置脉冲宽度为4/16
+
+/**
+ * @brief 设置闪烁的显示位
+ * 闪烁在刷新时叠加，不修改缓存内容，调用者无需重绘熄灭帧
+ * @param mask 显示位掩码(bit0为最左位)，0表示关闭闪烁
+ * @param period 闪烁半周期(ms)
+ */
+void TM1639BlinkSet(uint8_t mask, uint16_t period)
+{
+	if (mask == blink_mask && period == blink_period)
+	{
+		return;
+	}
+	TM1639FbMarkDirty(TM1639HwMask(mask | blink_mask));
+	blink_mask = mask;
+	blink_period = period;
+	blink_on = 1;
+	blink_due = xTaskGetTickCount() + period;
+}
+
+/**
+ * @brief 启动动画，同类动画运行中时只更新参数不重新开始
+ * @param type 动画类型
+ * @param period 帧周期(ms)
+ * @param frame_count 帧数
+ */
+static void TM1639AnimStart(TM1639AnimType_e type, uint16_t period, uint8_t frame_count)
+{
+	if (anim.type != type)
+	{
+		anim.type = type;
+		anim.frame = 0;
+		anim.due = xTaskGetTickCount() + period;
+	}
+	anim.period = period;
+	anim.frame_count = frame_count;
+	if (anim.frame >= frame_count)
+	{
+		anim.frame = 0;
+	}
+}
+
+/**
+ * @brief 跑马灯动画
+ * @param dir 1:顺时针 -1:逆时针
+ * @param period 帧周期(ms)
+ */
+void TM1639AnimMarquee(int8_t dir, uint16_t period)
+{
+	TM1639AnimStart(TM1639_ANIM_MARQUEE, period, TM1639_MARQUEE_FRAMES);
+	anim.step = dir;
+}
+
+/**
+ * @brief 单个显示位数值滚动动画(随机发牌时'位'的滚动)
+ * @param pos 显示位置 0-4
+ * @param max 滚动上限，在1-max之间循环
+ * @param period 帧周期(ms)
+ */
+void TM1639AnimRoll(uint8_t pos, uint8_t max, uint16_t period)
+{
+	TM1639AnimStart(TM1639_ANIM_ROLL, period, (max == 0) ? 1 : max);
+	anim.pos = pos;
+	anim.step = 1;
+}
+
+/**
+ * @brief 滚动字符串动画，从右侧移入左侧移出
+ * @param text 字符串(需保持有效直到动画停止)
+ * @param period 帧周期(ms)
+ */
+void TM1639AnimScroll(const char *text, uint16_t period)
+{
+	if (anim.type == TM1639_ANIM_SCROLL && anim.text != text)
+	{
+		anim.type = TM1639_ANIM_NONE; // 文本变化时从头开始
+	}
+	anim.text = text;
+	TM1639AnimStart(TM1639_ANIM_SCROLL, period, strlen(text) + 5);
+	anim.step = 1;
+}
+
+/**
+ * @brief 停止动画，保留当前显示内容
+ */
+void TM1639AnimStop(void)
+{
+	anim.type = TM1639_ANIM_NONE;
 }
 
+/**
+ * @brief 获取当前动画
+ * @return TM1639AnimType_e 动画类型
+ */
+TM1639AnimType_e TM1639AnimGetType(void)
+{
+	return anim.type;
+}
 
 /**
- * @brief 更改显示器的亮度
+ * @brief 把当前动画帧渲染到缓存
+ */
+static void TM1639AnimRender(void)
+{
+	switch (anim.type)
+	{
+	case TM1639_ANIM_MARQUEE:
+		MarqueeDisplay(anim.frame);
+		break;
+	case TM1639_ANIM_ROLL:
+		TM1639FbSetDigit(anim.pos, TM1639Glyph('1' + anim.frame) | (TM1639FbGetDigit(anim.pos) & SEG_DP));
+		break;
+	case TM1639_ANIM_SCROLL:
+		for (uint8_t i = 0; i < 5; i++)
+		{
+			int16_t index = anim.frame + i - 4;
+			char letter = (index >= 0 && index < anim.frame_count - 5) ? anim.text[index] : ' ';
+			TM1639FbSetDigit(i, TM1639Glyph(letter));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief 动画节拍处理，按时间戳推进闪烁相位和动画帧
+ * 以期望时刻累加推进，调用间隔抖动不会累积到动画节奏上
+ */
+void TM1639AnimTick(void)
+{
+	TickType_t now = xTaskGetTickCount();
+
+	if (blink_mask && (int32_t)(now - blink_due) >= 0)
+	{
+		blink_on = !blink_on;
+		blink_due += blink_period;
+		if ((int32_t)(now - blink_due) >= 0)
+		{
+			blink_due = now + blink_period; // 落后超过一个周期时重新对齐
+		}
+		TM1639FbMarkDirty(TM1639HwMask(blink_mask));
+	}
+
+	if (anim.type == TM1639_ANIM_NONE)
+	{
+		return;
+	}
+	if ((int32_t)(now - anim.due) >= 0)
+	{
+		anim.frame = (anim.step < 0) ? ((anim.frame == 0) ? anim.frame_count - 1 : anim.frame - 1)
+									 : ((anim.frame + 1 >= anim.frame_count) ? 0 : anim.frame + 1);
+		anim.due += anim.period;
+		if ((int32_t)(now - anim.due) >= 0)
+		{
+			anim.due = now + anim.period;
+		}
+	}
+	TM1639AnimRender();
+}
+
+/**
+ * @brief 获取下一次动画事件的时刻
+ * @param next 输出：下一次闪烁翻转或换帧的时刻
+ * @return bool 是否有待处理的动画事件
+ */
+bool TM1639AnimNextDue(uint32_t *next)
+{
+	bool pending = false;
+
+	if (blink_mask)
+	{
+		*next = blink_due;
+		pending = true;
+	}
+	if (anim.type != TM1639_ANIM_NONE && (!pending || (int32_t)(anim.due - *next) < 0))
+	{
+		*next = anim.due;
+		pending = true;
+	}
+	return pending;
+}
+
+/**
+ * @brief 更改显示器的正常亮度，降亮度和断电期间只记录，恢复时生效
  *
  * @param brightness 亮度等级 1-8, 对应1/16 - 14/16
  */
@@ -439,7 +820,11 @@ void TM1639SetBrightness(uint8_t brightness)
 {
 	brightness = (brightness == 0) ? 1 : (brightness > 8) ? 8
 														  : brightness;
-	TM1639WriteCmd(0x88 + brightness - 1); // 显示亮度
+	active_level = brightness;
+	if (power_state == TM1639_POWER_ACTIVE)
+	{
+		TM1639FbSetCtrl(0x88 + active_level - 1); // 显示亮度，下次刷新时下发
+	}
 }
 
 /**
@@ -449,7 +834,7 @@ void TM1639SetBrightness(uint8_t brightness)
  */
 void TM1639SetDisplayState(TM1639_Switch_e state)
 {
-	TM1639WriteCmd(state ? 0x8B : 0x80); // 启用/关闭显示
+	TM1639FbSetCtrl(state ? 0x8B : 0x80); // 启用/关闭显示，下次刷新时下发
 }
 
 /**
@@ -462,6 +847,152 @@ void TM1639PowerCtrl(TM1639_Switch_e PinState)
 	HAL_GPIO_WritePin(displayPower_GPIO_Port, displayPower_Pin, !(GPIO_PinState)PinState);
 }
 
+/**
+ * @brief 总线是否可访问：显示断电或恢复供电未就绪时不访问
+ */
+static bool TM1639BusReady(void)
+{
+	return power_state != TM1639_POWER_OFF && (int32_t)(xTaskGetTickCount() - power_ready) >= 0;
+}
+
+/**
+ * @brief 按当前亮度级别累计相对正常亮度节省的能耗
+ * @param now 当前时刻
+ */
+static void TM1639PowerAccount(TickType_t now)
+{
+	uint32_t dt = now - power_account;
+	uint8_t full = level_duty[active_level - 1];
+	uint8_t dim = level_duty[TM1639_DIM_LEVEL - 1];
+
+	power_account = now;
+	if (power_state == TM1639_POWER_DIM)
+	{
+		power_stat.dim_ms += dt;
+		power_stat.saved_ms += (full > dim) ? dt * (full - dim) / full : 0;
+	}
+	else if (power_state == TM1639_POWER_OFF)
+	{
+		power_stat.off_ms += dt;
+		power_stat.saved_ms += dt;
+	}
+}
+
+/**
+ * @brief 切换显示功耗状态
+ * @param state 目标状态
+ * @param now 当前时刻
+ */
+static void TM1639PowerApply(TM1639PowerState_e state, TickType_t now)
+{
+	if (state == TM1639_POWER_OFF)
+	{
+		// 断电前拉低总线，避免经IO给芯片反向供电
+		TM1639_GPIO->BSRR = BSRR_RESET(TM1639_STB | TM1639_CLK | TM1639_DIO);
+		TM1639PowerCtrl(TM1639_OFF);
+		LOG_DEBUG("TM1639 power gated.\n");
+	}
+	else
+	{
+		if (power_state == TM1639_POWER_OFF)
+		{
+			// 恢复供电后芯片寄存器已丢失，就绪后整帧重发上次的内容
+			TM1639PowerCtrl(TM1639_ON);
+			TM1639_GPIO->BSRR = BSRR_SET(TM1639_STB | TM1639_CLK | TM1639_DIO);
+			power_ready = now + pdMS_TO_TICKS(TM1639_POWER_UP_MS);
+			fb_dirty_start = 0;
+			fb_dirty_end = TM1639_FB_SIZE;
+			disp_ctrl_dirty = 1;
+		}
+		TM1639FbSetCtrl(0x88 + (state == TM1639_POWER_DIM ? TM1639_DIM_LEVEL : active_level) - 1);
+	}
+	power_state = state;
+}
+
+/**
+ * @brief 设置空闲降亮度与断电的时间
+ * @param dim_s 空闲多久后降亮度(s)，0表示不降亮度
+ * @param off_s 空闲多久后切断显示电源(s)，0表示不断电
+ */
+void TM1639GovernorConfig(uint16_t dim_s, uint16_t off_s)
+{
+	idle_dim_s = dim_s;
+	idle_off_s = off_s;
+}
+
+/**
+ * @brief 记录一次用户活动(按键、显示内容更新)
+ * @return true 显示当前处于降亮度或断电状态，调用者需唤醒显示任务以恢复
+ */
+bool TM1639GovernorKick(void)
+{
+	last_activity = xTaskGetTickCount();
+	return power_state != TM1639_POWER_ACTIVE;
+}
+
+/**
+ * @brief 显示功耗调节，由显示任务在每个时隙调用
+ * 断电期间TM1639按键无法读取，只能由电源键或触摸键唤醒
+ * @param next 输出下次需要调节的时刻(tick)
+ * @return true 有待处理的时刻
+ */
+bool TM1639GovernorTick(uint32_t *next)
+{
+	TickType_t now = xTaskGetTickCount();
+	TickType_t activity = last_activity;
+	uint32_t idle = (int32_t)(now - activity) > 0 ? now - activity : 0;
+	uint32_t dim_ms = idle_dim_s * 1000UL;
+	uint32_t off_ms = idle_off_s * 1000UL;
+	TM1639PowerState_e state = TM1639_POWER_ACTIVE;
+
+	TM1639PowerAccount(now);
+	if (off_ms != 0 && idle >= off_ms)
+	{
+		state = TM1639_POWER_OFF;
+	}
+	else if (dim_ms != 0 && idle >= dim_ms)
+	{
+		state = TM1639_POWER_DIM;
+	}
+	if (state != power_state)
+	{
+		TM1639PowerApply(state, now);
+	}
+
+	if ((int32_t)(power_ready - now) > 0)
+	{
+		*next = power_ready; // 等待芯片上电就绪
+		return true;
+	}
+	if (state == TM1639_POWER_ACTIVE && dim_ms != 0)
+	{
+		*next = activity + pdMS_TO_TICKS(dim_ms);
+		return true;
+	}
+	if (state != TM1639_POWER_OFF && off_ms != 0)
+	{
+		*next = activity + pdMS_TO_TICKS(off_ms);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief 获取显示功耗状态
+ */
+TM1639PowerState_e TM1639GetPowerState(void)
+{
+	return power_state;
+}
+
+/**
+ * @brief 获取显示能耗统计，在显示任务调节时更新
+ */
+const TM1639PowerStat_t *GetTM1639PowerStat(void)
+{
+	return &power_stat;
+}
+
 /**	
  * @brief 读取TM1639按键值
  *
@@ -470,36 +1001,21 @@ void TM1639PowerCtrl(TM1639_Switch_e PinState)
 static uint16_t TM1639ReadKey(void)
 {
 	uint16_t key_value = 0; // 存储解析后的按键值
+	uint16_t bits = 0;
 	uint16_t data_16b = 0;
-	uint8_t data_8bl = 0; // 从TM1639读取的原始数据
-	uint8_t data_8bh = 0;
 
 	// 设置TM1639为读取按键模式
-	set_strobe_pin(0);
+	TM1639_GPIO->BSRR = BSRR_RESET(TM1639_STB);
 	TM1639WriteByte(0x42); // 发送读键扫描模式命令
-	set_data_pin_mode(GPIO_PIN_RESET);
+	TM1639_GPIO->BSRR = BSRR_SET(TM1639_DIO);
+	set_data_pin_mode(0);
+	TM1639DelayLoops(read_wait_loops);
 
-	for (int i = 0; i < 16; i++)
-	{ // 读二个字节
-		set_clk_pin(0);
-		TM1639_Delay(2);
-		if (i < 8)
-		{
-			bitWrite(data_8bh, i, get_data_pin()); // 读第一个字节
-		}
-		else
-		{
-			bitWrite(data_8bl, (i - 8), get_data_pin()); // 读第二个字节
-		}
-		set_clk_pin(1);
-		TM1639_Delay(2);
-	}
-	set_data_pin_mode(GPIO_PIN_SET);
-	set_strobe_pin(1);
-	data[0] = data_8bh;
-	data[1] = data_8bl;
-	data_16b = data_8bh;
-	data_16b = data_16b << 8 | data_8bl; // 合并两个字节
+	bits = TM1639ReadBits(); // 读二个字节
+
+	set_data_pin_mode(1);
+	TM1639_GPIO->BSRR = BSRR_SET(TM1639_STB);
+	data_16b = (uint16_t)(bits << 8) | (bits >> 8); // 第一个字节在高8位
 	// 根据key_mask解析按键值
 	for (uint8_t i = 0; i < (sizeof(key_mask) / sizeof(key_mask[0])); i++)
 	{
@@ -537,130 +1053,89 @@ TM1639_KeyState_e parse_key_status(uint16_t key_value, uint8_t key_number)
  */               
 void TM1639Init(void)
 {
-	set_data_pin_mode(GPIO_PIN_SET);
-	set_strobe_pin(1);
-	set_clk_pin(1);
-	TM1639_Delay(2);	
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	uint32_t cycles = 0;
+
+#if TM1639_PHY == TM1639_PHY_DMA
+	TM1639DmaInit();
+#endif
+	// 按系统时钟换算延时循环数，使总线运行在TM1639额定最高时钟
+	cycles = SystemCoreClock / (2 * TM1639_CLK_HZ);
+	half_clk_loops = cycles > TM1639_DELAY_LOOP_CYCLES ? cycles / TM1639_DELAY_LOOP_CYCLES : 1;
+	read_wait_loops = SystemCoreClock / 1000000U * TM1639_READ_WAIT_US / TM1639_DELAY_LOOP_CYCLES;
+
+	// DIO配置一次上拉推挽输出，之后只切换MODER
+	GPIO_InitStruct.Pin = TM1639_DIO;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+	GPIO_InitStruct.Pull = GPIO_PULLUP;
+	HAL_GPIO_Init(TM1639_GPIO, &GPIO_InitStruct);
+	TM1639_GPIO->BSRR = BSRR_SET(TM1639_STB | TM1639_CLK | TM1639_DIO);
+	TM1639DelayLoops(half_clk_loops * 2);
 
 	TM1639WriteCmd(0x40); // 0100 0000	写数据到显示寄存器,自动地址增加
 	TM1639WriteCmd(0x87); // 1000 0111	显示控制,设置脉冲宽度为14/16
+	disp_ctrl = 0x87;
+	disp_ctrl_dirty = 0;
+	TM1639FbSetCtrl(0x88 + active_level - 1); // 正常亮度，随清屏一起下发
 
 	TM1639Clear();
-	start_hooking = 1;
+	key_due = xTaskGetTickCount();
+	last_activity = key_due;
+	power_account = key_due;
+#if TM1639_PHY_BENCH
+	TM1639PhyBenchmark();
+#endif
 }
 
 /**
- * @brief 获取指定按键的状态
- * @param key_id 按键编号
- * @return TM1639_KeyState_e 返回按键状态，KEY_DOWN表示按下，KEY_UP表示未按下
-*/
-static uint8_t Key_GetPortState(TM1639KeyId_e key_id)
+ * @brief TM1639读键时隙
+ * 总线只由显示任务访问，到期时在刷新显示之后读取一次按键，并根据按键活动调整扫描周期。
+ * 显示断电时不访问总线，TM1639按键视为全部松开，仍按周期返回以便扫描GPIO按键
+ * @param next 输出下次读键时刻(tick)
+ * @return true 本时隙完成了一次采样，调用者随后进行按键扫描
+ */
+bool TM1639KeyPoll(uint32_t *next)
 {
-	return parse_key_status(TM1639Key_Value, key_id + 1);
-}
+	TickType_t now = xTaskGetTickCount();
+	uint32_t start_cycles = 0;
+	uint16_t value = 0;
+	bool sampled = false;
 
-
-/**
- * @brief TM1639按键扫描
-*/
-void TM1639KeyScan(void)
-{
-    for (uint8_t i = 0; i < NUM_TM1639KEYS; i++)
-    {
-		tm1639_keys[i].last_state = tm1639_keys[i].state;
-        tm1639_keys[i].last = tm1639_keys[i].current;
-
-        tm1639_keys[i].current = Key_GetPortState(i);
-
-        if (tm1639_keys[i].state != TM1639KEY_LONG_PRESSED && tm1639_keys[i].state != TM1639KEY_LONG_PRESSED_BACK)
-        {
-            if (tm1639_keys[i].current == 0)
-            {
-                if (tm1639_keys[i].last == 1)
-                {
-                    tm1639_keys[i].state = TM1639KEY_PRESSED;
-                    LOG_DEBUG("TM1639 Key %d pressed.\n", i);
-                    tm1639_keys[i].press_time = 0;
-                }
-                else
-                {
-                    if (tm1639_keys[i].press_time > KEY_LONG_PRESS_THRESHOLD)
-                    {
-                        tm1639_keys[i].state = TM1639KEY_LONG_PRESSED;
-                        LOG_DEBUG("TM1639 Key %d long pressed.\n", i);
-                    }
-                }
-            }
-            else
-            {
-                if (tm1639_keys[i].last == 0)
-                {
-                    tm1639_keys[i].state = TM1639KEY_RELEASED;
-                    if (tm1639_keys[i].press_time < KEY_CLICK_THRESHOLD)
-                    {
-                        tm1639_keys[i].state = TM1639KEY_CLICKED;
-                        LOG_DEBUG("TM1639 Key %d clicked.\n", i);
-                    }
-                    else
-                    {
-                        LOG_DEBUG("TM1639 Key %d released.\n", i);
-                    }
-                }
-                else
-                {
-                    tm1639_keys[i].press_time = 0;
-                    tm1639_keys[i].state = TM1639KEY_IDLE;
-                }
-            }
-        }
-        else if(tm1639_keys[i].state == TM1639KEY_LONG_PRESSED)
-        {
-			if(tm1639_keys[i].last_state == TM1639KEY_LONG_PRESSED && tm1639_keys[i].state == TM1639KEY_LONG_PRESSED)
-			{
-				tm1639_keys[i].press_time = 0;
-				tm1639_keys[i].state = TM1639KEY_LONG_PRESSED_BACK;
-			}
-        }
-		else{
-			if (tm1639_keys[i].current == 1)
-            {
-                tm1639_keys[i].state = TM1639KEY_RELEASED;
-                LOG_DEBUG("TM1639 Key %d released.\n", i);
-            }
+	if (power_state != TM1639_POWER_OFF && !TM1639BusReady())
+	{
+		key_due = power_ready;
+	}
+	else if ((int32_t)(now - key_due) >= 0)
+	{
+		if (power_state != TM1639_POWER_OFF)
+		{
+			start_cycles = TM1639GetCycles();
+			value = TM1639ReadKey();
+			bus_stat.key_reads++;
+			bus_stat.key_cycles += TM1639GetCycles() - start_cycles;
 		}
-    }
-}
-
 
-/**
- * @brief TM1639按键处理
-*/
-void TM1639MsHandle(void)
-{
-	static uint8_t check_key_delay = 0;
-	if (check_key_delay > 2)
-	{
-		TM1639Key_Value = TM1639ReadKey();
-		check_key_delay = 0;
+		// 有键按下或键值变化都视为活动
+		if (value != 0 || value != TM1639Key_Value)
+		{
+			key_active_until = now + pdMS_TO_TICKS(TM1639_KEY_ACTIVE_HOLD);
+			last_activity = now;
+		}
+		TM1639Key_Value = value;
+		key_due = now + pdMS_TO_TICKS((int32_t)(key_active_until - now) > 0 ? TM1639_KEY_SCAN_FAST : TM1639_KEY_SCAN_SLOW);
+		sampled = true;
 	}
-	
-    for (uint8_t i = 0; i < NUM_TM1639KEYS; i++)
-    {
-        if (tm1639_keys[i].state == TM1639KEY_PRESSED)
-        {
-            tm1639_keys[i].press_time++;
-        }
-    }
-	check_key_delay += start_hooking;
+	*next = key_due;
+	return sampled;
 }
 
 /**
- * @brief 获取TM1639按键信息
- * @return TM1639key_t* 返回TM1639按键信息
+ * @brief 获取最近一次读取的TM1639按键值
+ * @return uint16_t 按下位图，bit n对应TM1639KeyId_e中的按键n
 */
-TM1639key_t *GetTM1639KeyInfo(void)
+uint16_t TM1639GetKeyValue(void)
 {
-    return tm1639_keys;
+	return TM1639Key_Value;
 }
 
 
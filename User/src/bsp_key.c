@@ -1,110 +1,214 @@
 #include "bsp_key.h"
+#include "TM1639.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include "log.h"
+#include "motor.h"
+#include "user_task.h"
+#include "bsp_opto.h"
 
 
-#define NUM_KEYS 2                   
-#define KEY_LONG_PRESS_THRESHOLD 2000 // 长按时长
-#define KEY_CLICK_THRESHOLD 500       // 单击时长
+// 消抖和事件判断以tick为单位
+typedef char key_tick_check[(configTICK_RATE_HZ == KEY_TICK_HZ) ? 1 : -1];
 
+static KeyDebounce_t key_db = KEY_DEBOUNCE_INIT;
 
-static key_t keys[NUM_KEYS] = {
-    {KEY_POWER, powerKey_GPIO_Port, powerKey_Pin, 1, 1, 0, KEY_IDLE, KEY_IDLE},
-    {KEY_TOUCH, touchKey_GPIO_Port, touchKey_Pin, 1, 1, 0, KEY_IDLE, KEY_IDLE},
-};
+// 按键事件环形缓冲：显示任务扫描写入，控制台任务读取(单生产者单消费者，无需加锁)
+static KeyEvent_t key_events[KEY_EVENT_QUEUE_SIZE];
+static volatile uint8_t event_head = 0; // 写位置，仅生产者修改
+static volatile uint8_t event_tail = 0; // 读位置，仅消费者修改
+static uint32_t event_lost = 0;         // 缓冲满丢弃的事件数
 
+// 电源键/触摸键下降沿中断，位定义同按键编号
+static volatile uint8_t key_irq = 0;
+static volatile uint32_t touch_irq_tick = 0;
+static KeyTouchStat_t touch_stat = {0};
+
+
+/**
+ * @brief 采样全部按键
+ *
+ * @return uint8_t 按下位图
+ */
+static uint8_t KeySample(void)
+{
+    uint8_t raw = (uint8_t)TM1639GetKeyValue();
+
+    if (HAL_GPIO_ReadPin(powerKey_GPIO_Port, powerKey_Pin) == PRESEED)
+    {
+        raw |= 1U << KEY_POWER;
+    }
+    if (HAL_GPIO_ReadPin(touchKey_GPIO_Port, touchKey_Pin) == PRESEED)
+    {
+        raw |= 1U << KEY_TOUCH;
+    }
+    return raw;
+}
+
+/**
+ * @brief 写入一个按键事件
+ *
+ * @param key 按键编号
+ * @param type 事件类型
+ * @param tick 事件时刻
+ * @param step 步进
+ */
+static void KeyEventPut(uint8_t key, KeyState_e type, uint32_t tick, uint8_t step)
+{
+    uint8_t head = event_head;
+
+    if (type != KEY_REPEAT)
+    {
+        LOG_DEBUG("Key %d event %d.\n", key, type);
+    }
+    if ((uint8_t)(head - event_tail) >= KEY_EVENT_QUEUE_SIZE)
+    {
+        event_lost++;
+        return;
+    }
+    key_events[head & (KEY_EVENT_QUEUE_SIZE - 1)].tick = tick;
+    key_events[head & (KEY_EVENT_QUEUE_SIZE - 1)].key = key;
+    key_events[head & (KEY_EVENT_QUEUE_SIZE - 1)].type = (uint8_t)type;
+    key_events[head & (KEY_EVENT_QUEUE_SIZE - 1)].step = step;
+    event_head = head + 1; // 内容写完后再发布
+}
 
 /**
  * @brief 按键扫描
+ * 采样全部按键后交给 KeyDebounceUpdate，状态变化写入事件缓冲
+ * @return uint8_t 本次产生的事件数
 */
-void KeyScan(void)
+uint8_t KeyScan(void)
 {
-    for (int i = 0; i < NUM_KEYS; i++)
+    return KeyDebounceUpdate(&key_db, KeySample(), xTaskGetTickCount(), KeyEventPut);
+}
+
+/**
+ * @brief 读取一个按键事件
+ *
+ * @param event 输出：按键事件
+ * @return true 读到事件，false 缓冲为空
+ */
+bool KeyEventGet(KeyEvent_t *event)
+{
+    uint8_t tail = event_tail;
+
+    if (tail == event_head)
     {
-        keys[i].last_state = keys[i].state;
-        keys[i].last = keys[i].current;
+        return false;
+    }
+    *event = key_events[tail & (KEY_EVENT_QUEUE_SIZE - 1)];
+    event_tail = tail + 1;
+    return true;
+}
+
+/**
+ * @brief 获取因缓冲满而丢弃的事件数
+ */
+uint32_t KeyEventLost(void)
+{
+    return event_lost;
+}
 
-        keys[i].current = HAL_GPIO_ReadPin(keys[i].port, keys[i].pin);
 
-        if (keys[i].state != KEY_LONG_PRESSED && keys[i].state != KEY_LONG_PRESSED_BACK)
+/**
+ * @brief EXTI下降沿中断回调：电源键/触摸键，光耦转交 OptoExtiIrq
+ * 触摸键在中断中直接切断两路H桥使能，暂停模式切换交给控制台任务
+ * @param GPIO_Pin 中断引脚
+ */
+void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin)
+{
+    uint32_t start = SysTick->VAL;
+    uint32_t cycles = 0;
+    BaseType_t woken = pdFALSE;
+
+    if (GPIO_Pin == touchKey_Pin)
+    {
+        MotorEmergencyCut();
+
+        // SysTick向下计数，跨越重装载时补一个周期
+        cycles = start - SysTick->VAL;
+        if ((int32_t)cycles < 0)
         {
-            if (keys[i].current == PRESEED)
-            {
-                if (keys[i].last == RELEASED)
-                {
-                    keys[i].state = KEY_PRESSED;
-                    LOG_DEBUG("Key %d pressed.\n", i);
-                    keys[i].press_time = 0;
-                }
-                else
-                {
-                    if (keys[i].press_time > KEY_LONG_PRESS_THRESHOLD)
-                    {//
-                        keys[i].state = KEY_LONG_PRESSED;
-                        LOG_DEBUG("Key %d long pressed.\n", i);
-                    }//   
-                }
-            }
-            else
-            {
-                if (keys[i].last == PRESEED)
-                {
-                    keys[i].state = KEY_RELEASED;
-                    if (keys[i].press_time < KEY_CLICK_THRESHOLD)
-                    {
-                        keys[i].state = KEY_CLICKED;
-                        LOG_DEBUG("Key %d clicked.\n", i);
-                    }
-                    else
-                    {
-                        LOG_DEBUG("Key %d released.\n", i);
-                    }
-                }
-                else
-                {   
-                    keys[i].press_time = 0;
-                    keys[i].state = KEY_IDLE;
-                }
-            }
+            cycles += SysTick->LOAD + 1;
         }
-        else if(keys[i].state == KEY_LONG_PRESSED)
+        touch_stat.count++;
+        touch_stat.cut_cycles = cycles;
+        if (cycles > touch_stat.cut_cycles_max)
         {
-			if(keys[i].last_state == KEY_LONG_PRESSED && keys[i].state == KEY_LONG_PRESSED)
-			{
-				keys[i].press_time = 0;
-				keys[i].state = KEY_LONG_PRESSED_BACK;
-			}
+            touch_stat.cut_cycles_max = cycles;
         }
-		else{
-			if (keys[i].current == RELEASED)
-            {
-                keys[i].state = KEY_RELEASED;
-                LOG_DEBUG("Key %d released.\n", i);
-            }
-		}
+        touch_irq_tick = xTaskGetTickCountFromISR();
+        key_irq |= 1U << KEY_TOUCH;
     }
+    else if (GPIO_Pin == powerKey_Pin)
+    {
+        key_irq |= 1U << KEY_POWER;
+    }
+    else
+    {
+        OptoExtiIrq(GPIO_Pin, GPIO_PIN_RESET); // 光耦开始遮挡
+        return;
+    }
+    ConsoleTaskNotifyFromISR(&woken);
+    portYIELD_FROM_ISR(woken);
 }
 
 /**
- * @brief 按键毫秒处理
-*/
-void KeyMsHandle(void)
+ * @brief 取出并清除待处理的按键中断
+ *
+ * @param touch_tick 输出：触摸中断时刻
+ * @return uint8_t 中断位图，位定义同按键编号
+ */
+uint8_t KeyIrqTake(uint32_t *touch_tick)
+{
+    uint8_t irq = 0;
+
+    __disable_irq();
+    irq = key_irq;
+    key_irq = 0;
+    *touch_tick = touch_irq_tick;
+    __enable_irq();
+    return irq;
+}
+
+/**
+ * @brief 查询待处理的按键中断，不清除
+ */
+uint8_t KeyIrqPending(void)
+{
+    return key_irq;
+}
+
+/**
+ * @brief 控制台已进入暂停，记录触摸到暂停的耗时
+ */
+void KeyTouchPauseDone(void)
 {
-    for (int i = 0; i < NUM_KEYS; i++)
+    uint32_t ms = xTaskGetTickCount() - touch_irq_tick;
+
+    touch_stat.pause_ms = ms;
+    if (ms > touch_stat.pause_ms_max)
     {
-        if (keys[i].state == KEY_PRESSED)
-        {
-            keys[i].press_time++;
-        }
+        touch_stat.pause_ms_max = ms;
     }
+    LOG_DEBUG("Touch cut %u cycles, pause %u ms.\n", (unsigned int)touch_stat.cut_cycles, (unsigned int)ms);
 }
 
+/**
+ * @brief 获取触摸急停耗时统计
+ */
+const KeyTouchStat_t *GetKeyTouchStat(void)
+{
+    return &touch_stat;
+}
 
 /**
  * @brief 获取按键信息
  *
- * @return const Key_inf_t* keys   按键信息
+ * @return const key_t* keys   按键信息，按统一按键编号索引
  */
 const key_t *GetKeyInfo(void)
 {
-    return keys;
-}
\ No newline at end of file
+    return key_db.keys;
+}
@@ -0,0 +1,197 @@
+#include "bsp_opto.h"
+#include "bsp_key.h"
+#include "motor.h"
+#include "user_task.h"
+
+
+// TIM14 16位计数，溢出中断扩展高16位，得到32位微秒时间戳
+static volatile uint16_t opto_time_hi = 0;
+
+// 计数边沿(遮挡→放开，电平变为RELEASED)环形缓冲：EXTI中断写入，运动控制读取(每路单生产者单消费者)
+static uint32_t opto_edges[NUM_OPTOS][OPTO_EDGE_QUEUE_SIZE];
+static uint16_t opto_width[NUM_OPTOS][OPTO_EDGE_QUEUE_SIZE]; // 遮挡时长 >> OPTO_WIDTH_SHIFT
+static volatile uint8_t edge_head[NUM_OPTOS] = {0}; // 写位置，仅中断修改
+static volatile uint8_t edge_tail[NUM_OPTOS] = {0}; // 读位置，仅消费者修改
+static uint32_t press_us[NUM_OPTOS] = {0};          // 最近一次开始遮挡的时刻
+static uint32_t edge_lost = 0;                      // 缓冲满丢弃的边沿数
+// 出牌口互锁：转盘未到位时牌头遮挡出牌光耦，立即制动出牌电机
+static volatile bool guard_on = false;
+static volatile bool guard_tripped = false;
+
+
+/**
+ * @brief 初始化光耦时基
+ * TIM14 按1MHz自由计数，光耦引脚的EXTI(双边沿)在MX_GPIO_Init中打开
+ */
+void OptoInit(void)
+{
+    __HAL_RCC_TIM14_CLK_ENABLE();
+
+    TIM14->CR1 = 0;
+    TIM14->PSC = SystemCoreClock / OPTO_TIMER_HZ - 1;
+    TIM14->ARR = 0xFFFF;
+    TIM14->EGR = TIM_EGR_UG; // 装载预分频
+    TIM14->SR = 0;
+    TIM14->DIER = TIM_DIER_UIE;
+
+    // 与EXTI同优先级，互不抢占
+    HAL_NVIC_SetPriority(TIM14_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(TIM14_IRQn);
+    TIM14->CR1 = TIM_CR1_CEN;
+}
+
+/**
+ * @brief 读取32位微秒时间戳
+ * 计数器刚溢出而中断尚未处理时，用挂起的UIF补上高位
+ */
+uint32_t OptoNowUs(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t hi, lo;
+
+    __disable_irq();
+    hi = opto_time_hi;
+    lo = (uint16_t)TIM14->CNT;
+    if ((TIM14->SR & TIM_SR_UIF) && lo < 0x8000U)
+    {
+        hi++;
+    }
+    __set_PRIMASK(primask);
+    return ((uint32_t)hi << 16) | lo;
+}
+
+/**
+ * @brief TIM14溢出中断
+ */
+void OptoTimerIrq(void)
+{
+    if (TIM14->SR & TIM_SR_UIF)
+    {
+        TIM14->SR = (uint32_t)~TIM_SR_UIF; // rc_w0，只清UIF
+        opto_time_hi++;
+    }
+}
+
+/**
+ * @brief 光耦EXTI边沿处理，在HAL的EXTI上升/下降沿回调中调用
+ * 遮挡开始记下时刻；放开时遮挡持续不短于 OPTO_GLITCH_US 才作为一次计数边沿写入缓冲
+ * @param GPIO_Pin 引脚
+ * @param level 边沿之后的电平
+ */
+void OptoExtiIrq(uint16_t GPIO_Pin, GPIO_PinState level)
+{
+    uint32_t now = OptoNowUs();
+    uint32_t width;
+    uint8_t opto, head;
+    BaseType_t woken = pdFALSE;
+
+    if (GPIO_Pin == rotateOptoKey_Pin)
+    {
+        opto = OPTO_ROTATE;
+    }
+    else if (GPIO_Pin == outputOptoKey_Pin)
+    {
+        opto = OPTO_OUTPUT;
+    }
+    else
+    {
+        return;
+    }
+
+    if (level != RELEASED)
+    {
+        press_us[opto] = now;
+        if (opto == OPTO_OUTPUT && guard_on)
+        {
+            MotorStop(&motor[OUTMOTOR], MOTOR_STOP_BRAKE);
+            guard_tripped = true;
+        }
+        return;
+    }
+    width = now - press_us[opto];
+    if (width < OPTO_GLITCH_US)
+    {
+        return;
+    }
+    width >>= OPTO_WIDTH_SHIFT;
+    head = edge_head[opto];
+    if ((uint8_t)(head - edge_tail[opto]) >= OPTO_EDGE_QUEUE_SIZE)
+    {
+        edge_lost++;
+        if (opto == OPTO_ROTATE)
+        {
+            motor[ROTATEMOTOR].homed = false; // 扇区号已不可信，下次发牌重新寻找原点槽
+        }
+        return;
+    }
+    opto_edges[opto][head & (OPTO_EDGE_QUEUE_SIZE - 1)] = now;
+    opto_width[opto][head & (OPTO_EDGE_QUEUE_SIZE - 1)] = (width > 0xFFFFU) ? 0xFFFFU : (uint16_t)width;
+    edge_head[opto] = head + 1; // 内容写完后再发布
+    DealTaskNotifyFromISR(&woken); // 唤醒发牌引擎
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief 取出一个计数边沿
+ * @param opto 光耦编号
+ * @param edge 输出：边沿时刻和遮挡时长
+ * @return true 取到边沿
+ */
+bool OptoEdgeGet(OptoId_e opto, OptoEdge_t *edge)
+{
+    uint8_t tail = edge_tail[opto];
+
+    if (tail == edge_head[opto])
+    {
+        return false;
+    }
+    edge->us = opto_edges[opto][tail & (OPTO_EDGE_QUEUE_SIZE - 1)];
+    edge->width = (uint32_t)opto_width[opto][tail & (OPTO_EDGE_QUEUE_SIZE - 1)] << OPTO_WIDTH_SHIFT;
+    edge_tail[opto] = tail + 1;
+    return true;
+}
+
+/**
+ * @brief 丢弃缓冲中的旧边沿，运动开始前调用
+ * @param opto 光耦编号
+ */
+void OptoFlush(OptoId_e opto)
+{
+    edge_tail[opto] = edge_head[opto];
+}
+
+/**
+ * @brief 缓冲满丢弃的边沿数
+ */
+uint32_t OptoEdgeLost(void)
+{
+    return edge_lost;
+}
+
+/**
+ * @brief 出牌口互锁开关
+ * 转动中预转出牌电机时打开，到位后关闭；打开期间牌头到达出牌光耦即制动出牌电机
+ * @param on true 打开
+ */
+void OptoGuardSet(bool on)
+{
+    guard_tripped = false;
+    guard_on = on;
+}
+
+/**
+ * @brief 互锁打开后是否已制动过出牌电机
+ */
+bool OptoGuardTripped(void)
+{
+    return guard_tripped;
+}
+
+/**
+ * @brief EXTI上升沿回调，光耦放开
+ * @param GPIO_Pin 引脚
+ */
+void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin)
+{
+    OptoExtiIrq(GPIO_Pin, GPIO_PIN_SET);
+}
@@ -4,46 +4,44 @@
 #include <string.h>
 #include "log.h"
 #include "motor.h"
+#include "deal.h"
+#include "bsp_opto.h"
 #include "adc.h"
 #include "flash_operation.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include "user_task.h"
 
 /* 全局变量 ------------------------------------------------------------------*/
 // 显示信息
 DisplayInfo_t displayInfo = {
-    .needUpdate = false,
     .content_type = DIGITAL_CONTENT,
-    .blink_en = UNBLINK,
-    .blink_state = BLINK_OFF,
-    .blink_period = 0,
+    .blink_mask = 0,
     .digital_content = {0},
     .string_content = {0},
     .dot_content = {0},
     .start_pos = 0,
     .start_pos2 = 0,
     .length = 0,
-    .marQuee_index = 0,
-    .marQuee_period = MARQUEE_PERIOD,
+    .marquee_dir = 1,
+    .roll_max = 0,
 };
 
 /* 私有变量 ------------------------------------------------------------------*/
-// 历史显示数据 - 用于确认是否需要刷新显示内容，后续可用以优化显示刷新
-DisplayInfo_t last_displayInfo = {
-    .needUpdate = false,
-    .content_type = DIGITAL_CONTENT,
-    .blink_en = UNBLINK,
-    .blink_state = BLINK_OFF,
-    .blink_period = 0,
-    .digital_content = {0},
-    .string_content = {0},
-    .dot_content = {0},
-    .start_pos = 0,
-    .start_pos2 = 0,
-    .length = 0,
-    .marQuee_index = 0,
-    .marQuee_period = MARQUEE_PERIOD,
-};
+// 显示帧双缓冲：控制台在displayInfo中编辑，发布时拷贝到后台帧并交换前台索引
+static DisplayInfo_t display_frame[2];
+static volatile uint8_t display_front = 0;
+// 显示内容版本号：奇数表示正在发布，读者据此判断是否有新帧及是否读到撕裂帧
+static volatile uint32_t display_version = 0;
+// 显示内容已修改，待发布
+static bool display_dirty = true;
+static uint8_t key_step = 1; // 当前按键事件的步进，连发后期为10
+
+// 座位标定：控制台记录各座位扇区，点动请求由工作任务执行
+static uint8_t cal_seat = 0;                // 正在标定的座位
+static uint8_t cal_sector[SEAT_MAX];        // 已确认座位的扇区
+static int16_t cal_shown = -1;              // 已显示的扇区号
+static int8_t cal_jog = 0;                  // 点动请求 1:正转一格 -1:反转一格
 
 // 控制结构体
 Console_t console = {
@@ -60,22 +58,7 @@ Console_t console = {
         .launch_card_pos = 0,
         .buzzer_time = 0}};
 
-// 电机
-Motor_t motor[2] = {
-    {.id = OUTMOTOR,
-     .current_pos = 0,
-     .cards = 0,
-     .totalCards = 0,
-     .direction = MOTOR_STOP},
-    {.id = ROTATEMOTOR,
-     .current_pos = 0,
-     .cards = 0,
-     .totalCards = 0,
-     .direction = MOTOR_STOP}};
-
 // 按键数据
-const key_t *key_info = NULL;
-TM1639key_t *tm1639_key_info = NULL;
 
 uint8_t view[2] = {0};
 
@@ -89,13 +72,16 @@ static void LaunchMenu_handle(void);
 static void PauseMenu_handle(TM1639KeyState_e launch_key, KeyState_e power_key);
 static void SafetyMenu_handle(void);
 static void CloseMenu_handle(void);
+static void CalibrateMenu_handle(TM1639KeyState_e launch_key, TM1639KeyState_e setting_key,
+                                 TM1639KeyState_e add_key, TM1639KeyState_e sub_key);
 
 static void SettingPlayerSwitch(int8_t delta);
 static void SettingSwitch(SettingItem_e item, int8_t delta);
 static void ModeSwitch(Console_t *console, CtrlMode_e target_mode);
 static void updateMenuDisplayNum(uint8_t menu_display_num[5], const MenuItem_t *menuItem);
 static void limitValue(uint8_t *value, uint8_t min, uint8_t max);
-static void checkDisplayUpdate(void);
+static void adjustValue(uint8_t *value, int8_t delta, uint8_t min, uint8_t max);
+static void DisplayPublish(void);
 static void buzzerWork(void);
 static void setBuzzer(void);
 static void recoverLowPowerMode(void);
@@ -110,21 +96,11 @@ static void volValueUpdate(void);
  */
 void ConsoleMsHandle(void)
 {
-    KeyMsHandle();
-    TM1639MsHandle();
     console.prepare_wait_time += console.prepare_wait_increment;
-    if (displayInfo.marQuee_period > 0)
-    {
-        displayInfo.marQuee_period--;
-    }
     if (console.main_menu.buzzer_time > 0)
     {
         console.main_menu.buzzer_time--;
     }
-    if (displayInfo.blink_period > 0)
-    {
-        displayInfo.blink_period--;
-    }
 }
 
 /**
@@ -144,10 +120,8 @@ void ConsoleInit(void)
     // xTaskResumeAll();
 
     LOG("\n\n///////////////////////\nstart running.\n");
-    key_info = GetKeyInfo(); // mark: 等待初始化完再绑定，下同
     LOG_INFO("Key initialization succeeded.\n");
     TM1639Init();
-    tm1639_key_info = GetTM1639KeyInfo();
     LOG_INFO("TM1639 initialization succeeded.\n");
     TM1639PowerCtrl(TM1639_ON);
     LOG_INFO("TM1639 power on.\n");
@@ -176,20 +150,36 @@ void sytryy()
 
 /**
  * @brief 控制台模式切换
+ * @param event 待处理的按键事件，NULL表示无按键事件
  */
-void ConsoleModeSwitch(void)
+void ConsoleModeSwitch(const KeyEvent_t *event)
 {
     // 全局[响应：1.SW6(长按关机) 2.touch 单击暂停]
     TM1639KeyState_e random, add, sub, setting, launch;
     KeyState_e power, touch;
-    random = tm1639_key_info[TM1639KEY_RANDOM].state;   // SW1
-    add = tm1639_key_info[TM1639KEY_ADD].state;         // SW2
-    sub = tm1639_key_info[TM1639KEY_SUB].state;         // SW3
-    setting = tm1639_key_info[TM1639KEY_SETTING].state; // SW4
-    launch = tm1639_key_info[TM1639KEY_LAUNCH].state;   // SW5
+    KeyState_e state[NUM_KEYS] = {KEY_IDLE};
 
-    power = key_info[KEY_POWER].state; // SW6
-    touch = key_info[KEY_TOUCH].state; // touch
+    // 每次只处理一个事件，事件对应按键之外的按键视为空闲
+    key_step = 1;
+    if (event != NULL && event->key < NUM_KEYS)
+    {
+        state[event->key] = (KeyState_e)event->type;
+        key_step = event->step;
+    }
+    random = (TM1639KeyState_e)state[TM1639KEY_RANDOM];   // SW1
+    add = (TM1639KeyState_e)state[TM1639KEY_ADD];         // SW2
+    sub = (TM1639KeyState_e)state[TM1639KEY_SUB];         // SW3
+    setting = (TM1639KeyState_e)state[TM1639KEY_SETTING]; // SW4
+    launch = (TM1639KeyState_e)state[TM1639KEY_LAUNCH];   // SW5
+
+    power = state[KEY_POWER]; // SW6
+    touch = state[KEY_TOUCH]; // touch
+
+    // 电源键/触摸键活动恢复显示亮度，显示断电时只有这两个键能唤醒
+    if ((power != KEY_IDLE || touch != KEY_IDLE) && TM1639GovernorKick())
+    {
+        TM1639TaskNotify();
+    }
 
     if (touch == KEY_PRESSED && console.ctrl_mode != PAUSE_MODE && console.ctrl_mode != SAFETY_MODE && console.ctrl_mode != SETTING_MODE)
     {
@@ -214,6 +204,17 @@ void ConsoleModeSwitch(void)
         console.main_menu.setting = DIRECTION_ROTATE_SETTING;
         ModeSwitch(&console, SETTING_MODE);
     }
+    else if (launch == TM1639KEY_LONG_PRESSED && console.ctrl_mode == IDLE_MODE &&
+             console.main_menu.playerCount >= 2 && console.main_menu.playerCount <= SEAT_MAX)
+    {
+        // 长按SW5: 进入座位标定，依次点动到每个座位并确认
+        LOG_DEBUG("Enter seat calibration mode.\n");
+        cal_seat = 0;
+        cal_shown = -1;
+        cal_jog = 0;
+        console.main_menu.launchMode = CALIBRATE_LAUNCH;
+        ModeSwitch(&console, CALIBRATE_MODE);
+    }
 
     switch (console.ctrl_mode)
     {
@@ -241,88 +242,105 @@ void ConsoleModeSwitch(void)
     case CLOSE_MODE:
         CloseMenu_handle();
         break;
+    case CALIBRATE_MODE:
+        CalibrateMenu_handle(launch, setting, add, sub);
+        break;
     default:
         break;
     }
+    WorkModeSwitch(); // 按模式切换结果提交/结束发牌计划
 
-    checkDisplayUpdate();
+    // 未进入暂停(如设置模式下的触摸)或已退出暂停时解除紧急切断
+    if (MotorIsCut() && console.ctrl_mode != PAUSE_MODE && !(KeyIrqPending() & (1U << KEY_TOUCH)))
+    {
+        MotorCutRelease();
+    }
+
+    if (display_dirty)
+    {
+        DisplayPublish();
+    }
     buzzerWork();
 
     volValueUpdate();
 }
 
 /**
- * @brief 检查是否需要刷新
+ * @brief 处理电源键/触摸键中断
+ * 触摸中断时电机使能已在中断中切断，这里补做暂停模式切换；电源键中断用于唤醒显示
+ * @return bool 是否处理了触摸事件
  */
-static void checkDisplayUpdate(void)
+bool ConsoleKeyIrq(void)
 {
-    // 默认认为需要更新
-    displayInfo.needUpdate = true;
+    KeyEvent_t event;
+    uint8_t irq = KeyIrqTake(&event.tick);
 
-    // 控制选中项闪烁
-    if (displayInfo.blink_en == ENBLINK)
+    if (irq & (1U << KEY_POWER))
     {
-        if (displayInfo.blink_period == 0)
+        if (TM1639GovernorKick())
         {
-            displayInfo.blink_state = !displayInfo.blink_state;
-            displayInfo.blink_period = BLINK_PERIOD;
+            TM1639TaskNotify();
         }
     }
-
-    // 如果内容类型相同，则继续检查具体内容
-    if (displayInfo.content_type == last_displayInfo.content_type)
+    if (irq & (1U << KEY_TOUCH))
     {
-        // 检查点内容是否相同
-        if (memcmp(&displayInfo.dot_content, &last_displayInfo.dot_content, sizeof(displayInfo.dot_content)) == 0)
+        event.key = KEY_TOUCH;
+        event.type = KEY_PRESSED;
+        event.step = 1;
+        ConsoleModeSwitch(&event);
+        if (console.ctrl_mode == PAUSE_MODE)
         {
-            bool isSame = false; // 用于记录除类型和点内容外，其他内容是否相同
+            KeyTouchPauseDone();
+        }
+        return true;
+    }
+    return false;
+}
 
-            switch (displayInfo.content_type)
-            {
-            case DIGITAL_CONTENT:
-                isSame = memcmp(&displayInfo.digital_content, &last_displayInfo.digital_content, sizeof(displayInfo.digital_content)) == 0 &&
-                         displayInfo.start_pos == last_displayInfo.start_pos &&
-                         displayInfo.length == last_displayInfo.length;
-                break;
-            case STRING_CONTENT:
-                isSame = memcmp(&displayInfo.string_content, &last_displayInfo.string_content, sizeof(displayInfo.string_content)) == 0 &&
-                         displayInfo.start_pos == last_displayInfo.start_pos &&
-                         displayInfo.length == last_displayInfo.length;
-                break;
-            case STRING_DIGITAL_CONTENT:
-                isSame = memcmp(&displayInfo.string_content, &last_displayInfo.string_content, sizeof(displayInfo.string_content)) == 0 &&
-                         memcmp(&displayInfo.digital_content, &last_displayInfo.digital_content, sizeof(displayInfo.digital_content)) == 0 &&
-                         displayInfo.start_pos == last_displayInfo.start_pos &&
-                         displayInfo.start_pos2 == last_displayInfo.start_pos2 &&
-                         displayInfo.length == last_displayInfo.length;
-                break;
-            case MARQUEE_CONTENT:
-                isSame = displayInfo.marQuee_index == last_displayInfo.marQuee_index;
-                break;
-            default:
-                // 默认更新，防止出现意外类型卡死
-                isSame = true;
-                break;
-            }
+/**
+ * @brief 发布显示内容
+ * 拷贝到后台帧后交换前台索引，版本号递增并通知显示任务
+ * 帧拷贝不是volatile访问，用编译器屏障固定它与版本号/前台索引的先后顺序(单核，无需DMB)
+ */
+static void DisplayPublish(void)
+{
+    uint8_t back = !display_front;
+
+    display_version++; // 奇数：发布中
+    __COMPILER_BARRIER(); // 帧拷贝不能被移到版本号变为奇数之前
+    memcpy(&display_frame[back], &displayInfo, sizeof(DisplayInfo_t));
+    __COMPILER_BARRIER(); // 帧拷贝完成后才交换前台并发布
+    display_front = back;
+    display_version++; // 偶数：发布完成
+    display_dirty = false;
+    TM1639TaskNotify();
+}
 
-            // 如果所有检查项都相同，则不需要更新
-            if (isSame)
-            {
-                displayInfo.needUpdate = false;
-            }
+/**
+ * @brief 获取最新发布的显示内容
+ * @param frame 输出：显示内容
+ * @param version 输入已渲染的版本号，输出新版本号
+ * @return bool 是否获取到新内容
+ */
+bool DisplayFetch(DisplayInfo_t *frame, uint32_t *version)
+{
+    uint32_t v = 0;
+
+    do
+    {
+        v = display_version;
+        if (v == *version || (v & 1))
+        {
+            // 无新内容，或正在发布(发布完成后会再次通知)
+            return false;
         }
-    }
+        __COMPILER_BARRIER(); // 先读版本号再拷贝
+        memcpy(frame, &display_frame[display_front], sizeof(DisplayInfo_t));
+        __COMPILER_BARRIER(); // 拷贝完成后再比较版本号
+    } while (v != display_version); // 拷贝期间有新发布，重新读取
 
-    // 同步历史记录，
-    memcpy(&last_displayInfo.digital_content, &displayInfo.digital_content, sizeof(displayInfo.digital_content));
-    memcpy(&last_displayInfo.string_content, &displayInfo.string_content, sizeof(displayInfo.string_content));
-    memcpy(&last_displayInfo.dot_content, &displayInfo.dot_content, sizeof(displayInfo.dot_content));
-    last_displayInfo.content_type = displayInfo.content_type;
-    last_displayInfo.start_pos = displayInfo.start_pos;
-    last_displayInfo.start_pos2 = displayInfo.start_pos2;
-    last_displayInfo.length = displayInfo.length;
-    last_displayInfo.marQuee_index = displayInfo.marQuee_index;
-    last_displayInfo.marQuee_period = displayInfo.marQuee_period;
+    *version = v;
+    return true;
 }
 
 /**
@@ -398,21 +416,25 @@ static void SetPlayerLaunchMenu_handle(TM1639KeyState_e launch_key, TM1639KeySta
         memcpy(&console.main_menu, &console.setting_menu, sizeof(console.setting_menu));
         ModeSwitch(&console, IDLE_MODE);
     }
-    else if (add_key == TM1639KEY_CLICKED)
+    else if (add_key == TM1639KEY_CLICKED || add_key == TM1639KEY_REPEAT)
     {
-        // 单击SW2: 增加当前选中项的值
-        delta = 1;
+        // 单击/按住SW2: 增加当前选中项的值
+        delta = key_step;
         setBuzzer();
-        LOG_INFO("set player num +1\n", console.setting_menu.setting);
+        LOG_INFO("set player num +%d\n", delta);
     }
-    else if (sub_key == TM1639KEY_CLICKED)
+    else if (sub_key == TM1639KEY_CLICKED || sub_key == TM1639KEY_REPEAT)
     {
-        // 单击SW3: 减少当前选中项的值
-        delta = -1;
+        // 单击/按住SW3: 减少当前选中项的值
+        delta = -key_step;
         setBuzzer();
-        LOG_INFO("set player num -1\n", console.setting_menu.setting);
+        LOG_INFO("set player num %d\n", delta);
     }
 
+    if (delta != 0)
+    {
+        display_dirty = true;
+    }
     SettingPlayerSwitch(delta);
     // 设置项切换至单独状态
 }
@@ -442,6 +464,7 @@ static void SettingMenu_handle(TM1639KeyState_e launch_key, TM1639KeyState_e ran
         // 单击SW4
         // 单击SW4: 切换下一项设置
         console.main_menu.setting++;
+        display_dirty = true;
         // 当玩家人数在2/3时才会进入 左右发牌/单旋转发牌模式 的选择
         if (console.main_menu.setting == DEALING_MODE_SETTING)
         {
@@ -463,18 +486,22 @@ static void SettingMenu_handle(TM1639KeyState_e launch_key, TM1639KeyState_e ran
             LOG_INFO("setting item move to %d\n", console.main_menu.setting);
         }
     }
-    else if (add_key == TM1639KEY_CLICKED)
+    else if (add_key == TM1639KEY_CLICKED || add_key == TM1639KEY_REPEAT)
     {
-        // 单击SW2: 增加当前选中项的值
-        delta = 1;
+        // 单击/按住SW2: 增加当前选中项的值
+        delta = key_step;
         setBuzzer();
     }
-    else if (sub_key == TM1639KEY_CLICKED)
+    else if (sub_key == TM1639KEY_CLICKED || sub_key == TM1639KEY_REPEAT)
     {
-        // 单击SW3: 减少当前选中项的值
-        delta = -1;
+        // 单击/按住SW3: 减少当前选中项的值
+        delta = -key_step;
         setBuzzer();
     }
+    if (delta != 0)
+    {
+        display_dirty = true;
+    }
     SettingSwitch(console.main_menu.setting, delta);
 }
 
@@ -501,6 +528,10 @@ static void LaunchMenu_handle(void)
         break;
 
     case RANDOM_LAUNCH:
+        // '位'在1-玩家数之间滚动
+        updateMenuDisplayNum(displayInfo.digital_content, &console.main_menu);
+        displayInfo.roll_max = console.main_menu.playerCount;
+        displayInfo.content_type = ROLL_CONTENT;
         break;
 
     default:
@@ -516,31 +547,25 @@ static void LaunchMenu_handle(void)
 static void PauseMenu_handle(TM1639KeyState_e launch_key, KeyState_e power_key)
 {
     uint8_t menu_display_dot[5] = {0};
-    char menu_display_string[5] = {'\0'};
 
     if (launch_key == TM1639KEY_CLICKED)
     {
+        // 单击SW5: 从暂停处继续发牌
+        DealResume();
         ModeSwitch(&console, console.last_mode);
     }
     else if (power_key == KEY_CLICKED)
     {
+        // 单击SW6: 放弃本次发牌
+        console.main_menu.launchMode = NO_LAUNCH;
         ModeSwitch(&console, IDLE_MODE);
     }
-    console.main_menu.launchMode = NO_LAUNCH;
-    outMotorStop(&motor[OUTMOTOR]);
-    rotateMotorStop(&motor[ROTATEMOTOR]);
+    else
+    {
+        DealPause(); // 引擎停止电机并保留当前步骤的进度
+    }
     displayInfo.content_type = STRING_CONTENT;
-    menu_display_string[0] = 'P';
-    menu_display_string[1] = 'A';
-    menu_display_string[2] = 'U';
-    menu_display_string[3] = 'S';
-    menu_display_string[4] = 'E';
-    menu_display_dot[0] = 0;
-    menu_display_dot[1] = 0;
-    menu_display_dot[2] = 0;
-    menu_display_dot[3] = 0;
-    menu_display_dot[4] = 0;
-    memcpy(&displayInfo.string_content, &menu_display_string, sizeof(menu_display_string));
+    memcpy(&displayInfo.string_content, "PAUSE", sizeof(displayInfo.string_content));
     memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
     displayInfo.start_pos = 0;
     displayInfo.length = 5;
@@ -590,53 +615,104 @@ static void CloseMenu_handle(void)
 }
 
 /**
- * @brief 设置项[位]切换处理
- * @param delta 增量
+ * @brief 座位标定模式处理
+ * 显示"C 座位 扇区"；SW2/SW3点动转盘一格，SW5确认当前座位，全部确认后保存；SW4放弃
+ * @param launch_key 发牌键
+ * @param setting_key 设置键
+ * @param add_key 加键
+ * @param sub_key 减键
  */
-static void SettingPlayerSwitch(int8_t delta)
+static void CalibrateMenu_handle(TM1639KeyState_e launch_key, TM1639KeyState_e setting_key,
+                                 TM1639KeyState_e add_key, TM1639KeyState_e sub_key)
 {
     uint8_t menu_display_num[5] = {0};
-    uint8_t menu_display_dot[5] = {0, 1, 1, 0, 0};
-    char menu_display_string[5] = {'\0'};
+    uint8_t menu_display_dot[5] = {0};
+    int16_t sector = motor[ROTATEMOTOR].homed ? motor[ROTATEMOTOR].current_pos : -1;
+    uint8_t i;
 
-    console.setting_menu.playerCount += delta;
-    limitValue(&console.setting_menu.playerCount, 0, 8);
-    displayInfo.content_type = DIGITAL_CONTENT;
-    if (last_displayInfo.digital_content[0] == 10 && last_displayInfo.digital_content[1] == 10)
+    if (console.main_menu.launchMode != CALIBRATE_LAUNCH)
     {
-        menu_display_num[0] = console.setting_menu.deckCount / 10;
-        menu_display_num[1] = console.setting_menu.deckCount % 10;
-        menu_display_num[2] = console.setting_menu.playerCount % 10;
-        menu_display_dot[0] = 0;
-        menu_display_dot[1] = 1;
-        menu_display_dot[2] = 1;
-        menu_display_dot[3] = 0;
-        menu_display_dot[4] = 0;
-        memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
-        memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-        displayInfo.start_pos = 0;
-        displayInfo.length = 3;
+        // 找不到原点槽，放弃本次标定
+        LOG_WARN("seat calibration aborted\n");
+        ModeSwitch(&console, IDLE_MODE);
+        return;
     }
-    else
+
+    if (launch_key == TM1639KEY_CLICKED && sector >= 0 && cal_jog == 0 && DealGetState() == DEAL_IDLE)
     {
-        if (displayInfo.blink_state == BLINK_OFF)
+        // 单击SW5: 确认当前座位
+        for (i = 0; i < cal_seat; i++)
         {
-            menu_display_num[0] = 10;
+            if (cal_sector[i] == sector)
+            {
+                LOG_WARN("seat %d already at sector %d\n", i + 1, sector);
+                return;
+            }
         }
-        else
+        cal_sector[cal_seat++] = (uint8_t)sector;
+        setBuzzer();
+        LOG_INFO("seat %d at sector %d\n", cal_seat, sector);
+        if (cal_seat >= console.main_menu.playerCount)
         {
-            menu_display_num[0] = console.setting_menu.playerCount % 10;
+            // 发牌结束时随学习参数写入flash
+            MotorSeatSet(cal_sector, cal_seat);
+            console.main_menu.launchMode = NO_LAUNCH;
+            ModeSwitch(&console, IDLE_MODE);
+            return;
         }
-        menu_display_dot[0] = 1;
-        menu_display_dot[1] = 0;
-        menu_display_dot[2] = 0;
-        menu_display_dot[3] = 0;
-        menu_display_dot[4] = 0;
-        memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
-        memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-        displayInfo.start_pos = 2;
-        displayInfo.length = 1;
+        display_dirty = true;
+    }
+    else if (setting_key == TM1639KEY_CLICKED)
+    {
+        // 单击SW4: 放弃标定
+        console.main_menu.launchMode = NO_LAUNCH;
+        ModeSwitch(&console, IDLE_MODE);
+        return;
+    }
+    else if (add_key == TM1639KEY_CLICKED || add_key == TM1639KEY_REPEAT)
+    {
+        // 单击/按住SW2: 正转一格
+        cal_jog = 1;
     }
+    else if (sub_key == TM1639KEY_CLICKED || sub_key == TM1639KEY_REPEAT)
+    {
+        // 单击/按住SW3: 反转一格
+        cal_jog = -1;
+    }
+
+    if (sector != cal_shown)
+    {
+        cal_shown = sector;
+        display_dirty = true;
+    }
+    menu_display_num[0] = cal_seat + 1;
+    menu_display_num[1] = 10; // 空白
+    menu_display_num[2] = (sector >= 0) ? sector / 10 : 10;
+    menu_display_num[3] = (sector >= 0) ? sector % 10 : 10;
+    memcpy(&displayInfo.string_content, "C    ", sizeof(displayInfo.string_content));
+    memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
+    memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
+    displayInfo.content_type = STRING_DIGITAL_CONTENT;
+    displayInfo.start_pos = 0;
+    displayInfo.start_pos2 = 1;
+    displayInfo.length = 5;
+}
+
+/**
+ * @brief 设置项[位]切换处理
+ * @param delta 增量
+ */
+static void SettingPlayerSwitch(int8_t delta)
+{
+    uint8_t menu_display_dot[5] = {0, 1, 1, 0, 0};
+
+    adjustValue(&console.setting_menu.playerCount, delta, 0, 8);
+    displayInfo.content_type = DIGITAL_CONTENT;
+    updateMenuDisplayNum(displayInfo.digital_content, &console.setting_menu);
+    memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
+    displayInfo.start_pos = 0;
+    displayInfo.length = 5;
+    displayInfo.blink_mask = 0x04; // '位'闪烁
 }
 
 /**
@@ -648,200 +724,66 @@ static void SettingSwitch(SettingItem_e item, int8_t delta)
 {
     uint8_t menu_display_num[5] = {0};
     uint8_t menu_display_dot[5] = {0, 1, 1, 0, 0};
-    char menu_display_string[5] = {'\0'};
+    const char *menu_string = NULL;
+    uint8_t script;
 
     // 更新选中项数值
     switch (item)
     {
     case BASECARD_COUNT_SETING: // 底牌数量变更
-        console.setting_menu.deckCount += delta;
-        limitValue(&console.setting_menu.deckCount, 0, 99);
-        displayInfo.content_type = DIGITAL_CONTENT;
-        if (displayInfo.blink_state == BLINK_OFF)
-        {
-            menu_display_num[0] = 10;
-            menu_display_num[1] = 10;
-        }
-        else
-        {
-            menu_display_num[0] = console.setting_menu.deckCount / 10;
-            menu_display_num[1] = console.setting_menu.deckCount % 10;
-        }
-        menu_display_dot[0] = 0;
-        menu_display_dot[1] = 1;
-        menu_display_dot[2] = 1;
-        menu_display_dot[3] = 0;
-        menu_display_dot[4] = 0;
-        memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
-
-        memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-        displayInfo.start_pos = 0;
-        displayInfo.length = 2;
+        adjustValue(&console.setting_menu.deckCount, delta, 0, 99);
+        displayInfo.blink_mask = 0x03; // '底'闪烁
         break;
     case PLAYER_COUNT_SETTING: // 玩家数量变更
-        console.setting_menu.playerCount += delta;
-        limitValue(&console.setting_menu.playerCount, 0, 8);
-        displayInfo.content_type = DIGITAL_CONTENT;
-        if (last_displayInfo.digital_content[0] == 10 && last_displayInfo.digital_content[1] == 10)
-        {
-            menu_display_num[0] = console.setting_menu.deckCount / 10;
-            menu_display_num[1] = console.setting_menu.deckCount % 10;
-            menu_display_num[2] = console.setting_menu.playerCount % 10;
-            menu_display_dot[0] = 0;
-            menu_display_dot[1] = 1;
-            menu_display_dot[2] = 1;
-            menu_display_dot[3] = 0;
-            menu_display_dot[4] = 0;
-            memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
-            memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-            displayInfo.start_pos = 0;
-            displayInfo.length = 3;
-        }
-        else
-        {
-            if (displayInfo.blink_state == BLINK_OFF)
-            {
-                menu_display_num[0] = 10;
-            }
-            else
-            {
-                menu_display_num[0] = console.setting_menu.playerCount % 10;
-            }
-            menu_display_dot[0] = 1;
-            menu_display_dot[1] = 0;
-            menu_display_dot[2] = 0;
-            menu_display_dot[3] = 0;
-            menu_display_dot[4] = 0;
-            memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
-            memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-            displayInfo.start_pos = 2;
-            displayInfo.length = 1;
-        }
+        adjustValue(&console.setting_menu.playerCount, delta, 0, 8);
+        displayInfo.blink_mask = 0x04; // '位'闪烁
         break;
     case LAUNCH_COUNT_SETTING: // 发牌数量变更
-        console.setting_menu.cardCount += delta;
-        limitValue(&console.setting_menu.cardCount, 0, 99);
-        displayInfo.content_type = DIGITAL_CONTENT;
-        if (last_displayInfo.digital_content[0] == 10 && last_displayInfo.digital_content[1] == 0)
-        {
-            menu_display_num[0] = console.setting_menu.playerCount % 10;
-            menu_display_num[1] = console.setting_menu.cardCount / 10;
-            menu_display_num[2] = console.setting_menu.cardCount % 10;
-            menu_display_dot[0] = 1;
-            menu_display_dot[1] = 0;
-            menu_display_dot[2] = 0;
-            menu_display_dot[3] = 0;
-            menu_display_dot[4] = 0;
-            memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
-            memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-            displayInfo.start_pos = 2;
-            displayInfo.length = 3;
-        }
-        else
-        {
-            if (displayInfo.blink_state == BLINK_OFF)
-            {
-                menu_display_num[0] = 10;
-                menu_display_num[1] = 10;
-            }
-            else
-            {
-                menu_display_num[0] = console.setting_menu.cardCount / 10;
-                menu_display_num[1] = console.setting_menu.cardCount % 10;
-            }
-            menu_display_dot[0] = 0;
-            menu_display_dot[1] = 0;
-            menu_display_dot[2] = 0;
-            menu_display_dot[3] = 0;
-            menu_display_dot[4] = 0;
-            memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
-            memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-            displayInfo.start_pos = 3;
-            displayInfo.length = 2;
-        }
-
+        adjustValue(&console.setting_menu.cardCount, delta, 0, 99);
+        displayInfo.blink_mask = 0x18; // '张'闪烁
         break;
     case BURST_COUNT_SETTING: // 连发数量变更
-        console.setting_menu.burstCount += delta;
-        limitValue(&console.setting_menu.burstCount, 0, 99);
+        adjustValue(&console.setting_menu.burstCount, delta, 0, 99);
         displayInfo.content_type = STRING_DIGITAL_CONTENT;
-        if (displayInfo.blink_state == BLINK_OFF)
-        {
-            menu_display_num[0] = 10;
-            menu_display_num[1] = 10;
-        }
-        else
-        {
-            menu_display_num[0] = console.setting_menu.burstCount / 10;
-            menu_display_num[1] = console.setting_menu.burstCount % 10;
-        }
-        // 显示连发
-        menu_display_string[0] = 'L';
-        menu_display_string[1] = 'F';
-        menu_display_string[2] = '-';
-        menu_display_dot[0] = 0;
-        menu_display_dot[1] = 0;
-        menu_display_dot[2] = 0;
-        menu_display_dot[3] = 0;
-        menu_display_dot[4] = 0;
-
-        // 写入显示数据
-        memcpy(&displayInfo.string_content, &menu_display_string, sizeof(menu_display_string));
+        menu_display_num[0] = console.setting_menu.burstCount / 10;
+        menu_display_num[1] = console.setting_menu.burstCount % 10;
+        memset(&menu_display_dot, 0, sizeof(menu_display_dot));
+
+        // 写入显示数据，显示连发
+        memcpy(&displayInfo.string_content, "LF-  ", sizeof(displayInfo.string_content));
         memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
         memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
         displayInfo.start_pos = 0;
         displayInfo.start_pos2 = 3;
         displayInfo.length = 5;
-        break;
-    case DEALING_MODE_SETTING: // 发牌模式变更
+        displayInfo.blink_mask = 0x18;
+        return;
+    case DEALING_MODE_SETTING: // 发牌模式变更，摆动 -> 旋转 -> 各牌局脚本循环
         if (delta != 0)
         {
-            if (console.setting_menu.dealMode == ROTATE_DEAL)
-            {
-                console.setting_menu.dealMode = SWAY_DEAL;
-            }
-            else
-            {
-                console.setting_menu.dealMode = ROTATE_DEAL;
-            }
+            script = (uint8_t)console.setting_menu.dealMode;
+            script = (script >= SCRIPT_DEAL + deal_script_num) ? SWAY_DEAL : script;
+            script = (uint8_t)((script + ((delta > 0) ? 1 : SCRIPT_DEAL + deal_script_num - 1)) % (SCRIPT_DEAL + deal_script_num));
+            console.setting_menu.dealMode = (DealingMode_e)script;
         }
-        displayInfo.content_type = STRING_CONTENT;
-        if (displayInfo.blink_state == BLINK_OFF)
+        if (console.setting_menu.dealMode >= SCRIPT_DEAL)
         {
-            menu_display_string[0] = 'z';
-            menu_display_string[1] = 'z';
-            menu_display_string[2] = 'z';
-            menu_display_string[3] = 'z';
-            menu_display_string[4] = 'z';
-        }
-        else
-        {
-            if (console.setting_menu.dealMode == ROTATE_DEAL)
-            {
-                menu_display_string[0] = 'F';
-                menu_display_string[1] = '-';
-                menu_display_string[2] = 'F';
-                menu_display_string[3] = '-';
-                menu_display_string[4] = 'F';
-            }
-            else
-            {
-                menu_display_string[0] = '\0';
-                menu_display_string[1] = 'F';
-                menu_display_string[2] = 'F';
-                menu_display_string[3] = 'F';
-                menu_display_string[4] = '\0';
-            }
+            // 显示"GA-xx"，xx为牌局编号
+            script = (uint8_t)(console.setting_menu.dealMode - SCRIPT_DEAL + 1);
+            displayInfo.content_type = STRING_DIGITAL_CONTENT;
+            menu_display_num[0] = script / 10;
+            menu_display_num[1] = script % 10;
+            memset(&menu_display_dot, 0, sizeof(menu_display_dot));
+            memcpy(&displayInfo.string_content, "GA-  ", sizeof(displayInfo.string_content));
+            memcpy(&displayInfo.digital_content, &menu_display_num, sizeof(menu_display_num));
+            memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
+            displayInfo.start_pos = 0;
+            displayInfo.start_pos2 = 3;
+            displayInfo.length = 5;
+            displayInfo.blink_mask = 0x1F;
+            return;
         }
-        menu_display_dot[0] = 0;
-        menu_display_dot[1] = 0;
-        menu_display_dot[2] = 0;
-        menu_display_dot[3] = 0;
-        menu_display_dot[4] = 0;
-        memcpy(&displayInfo.string_content, &menu_display_string, sizeof(menu_display_string));
-        memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-        displayInfo.start_pos = 0;
-        displayInfo.length = 5;
+        menu_string = (console.setting_menu.dealMode == ROTATE_DEAL) ? "F-F-F" : " FFF ";
         break;
     case DEALING_ORDER_SETTING: // 发牌顺序变更
         if (delta != 0)
@@ -855,43 +797,7 @@ static void SettingSwitch(SettingItem_e item, int8_t delta)
                 console.setting_menu.dealOrder = BOTTOM_LAST_DEAL;
             }
         }
-        displayInfo.content_type = STRING_CONTENT;
-        if (displayInfo.blink_state == BLINK_OFF)
-        {
-            menu_display_string[0] = 'z';
-            menu_display_string[1] = 'z';
-            menu_display_string[2] = 'z';
-            menu_display_string[3] = 'z';
-            menu_display_string[4] = 'z';
-        }
-        else
-        {
-            if (console.setting_menu.dealOrder == BOTTOM_LAST_DEAL)
-            {
-                menu_display_string[0] = 'F';
-                menu_display_string[1] = 'F';
-                menu_display_string[2] = 'F';
-                menu_display_string[3] = 'F';
-                menu_display_string[4] = 'd';
-            }
-            else
-            {
-                menu_display_string[0] = 'd';
-                menu_display_string[1] = 'F';
-                menu_display_string[2] = 'F';
-                menu_display_string[3] = 'F';
-                menu_display_string[4] = 'F';
-            }
-        }
-        menu_display_dot[0] = 0;
-        menu_display_dot[1] = 0;
-        menu_display_dot[2] = 0;
-        menu_display_dot[3] = 0;
-        menu_display_dot[4] = 0;
-        memcpy(&displayInfo.string_content, &menu_display_string, sizeof(menu_display_string));
-        memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
-        displayInfo.start_pos = 0;
-        displayInfo.length = 5;
+        menu_string = (console.setting_menu.dealOrder == BOTTOM_LAST_DEAL) ? "FFFFd" : "dFFFF";
         break;
 
     case DIRECTION_ROTATE_SETTING:
@@ -906,26 +812,33 @@ static void SettingSwitch(SettingItem_e item, int8_t delta)
                 console.setting_menu.dirRotate = CLOCKWISE;
             }
         }
-        if (displayInfo.marQuee_period == 0)
-        {
-            if (console.setting_menu.dirRotate == CLOCKWISE)
-            {
-                displayInfo.marQuee_index++;
-            }
-            else
-            {
-                displayInfo.marQuee_index--;
-            }
-            displayInfo.marQuee_period = MARQUEE_PERIOD;
-        }
-
-        limitValue(&displayInfo.marQuee_index, 0, 13);
+        // 跑马灯由显示驱动按MARQUEE_PERIOD推进
+        displayInfo.marquee_dir = (console.setting_menu.dirRotate == CLOCKWISE) ? 1 : -1;
         displayInfo.content_type = MARQUEE_CONTENT;
-        break;
+        displayInfo.blink_mask = 0;
+        return;
 
     default:
-        break;
+        return;
     }
+
+    if (menu_string != NULL)
+    {
+        // 模式选择整屏闪烁
+        displayInfo.content_type = STRING_CONTENT;
+        memset(&menu_display_dot, 0, sizeof(menu_display_dot));
+        memcpy(&displayInfo.string_content, menu_string, sizeof(displayInfo.string_content));
+        displayInfo.blink_mask = 0x1F;
+    }
+    else
+    {
+        // 数值设置沿用主菜单布局，只闪烁选中项
+        displayInfo.content_type = DIGITAL_CONTENT;
+        updateMenuDisplayNum(displayInfo.digital_content, &console.setting_menu);
+    }
+    memcpy(&displayInfo.dot_content, &menu_display_dot, sizeof(menu_display_dot));
+    displayInfo.start_pos = 0;
+    displayInfo.length = 5;
 }
 
 /**
@@ -946,21 +859,22 @@ static void ModeSwitch(Console_t *console, CtrlMode_e target_mode)
 {
     console->last_mode = console->ctrl_mode;
     console->ctrl_mode = target_mode;
+    display_dirty = true;
 
+    if (console->last_mode == CALIBRATE_MODE && target_mode != PAUSE_MODE)
+    {
+        // 离开标定模式(长按其它键等)时停止点动，暂停后可回到标定
+        console->main_menu.launchMode = NO_LAUNCH;
+    }
     if ((target_mode == SETTING_MODE || target_mode == SETPLAYER_LAUNCH_MODE) && console->last_mode != PAUSE_MODE)
     {
         // 进入设置前保存当前当前状态
         memcpy(&console->setting_menu, &console->main_menu, sizeof(MenuItem_t));
     }
-    if (target_mode == SETTING_MODE || target_mode == SETPLAYER_LAUNCH_MODE)
-    {
-        // 打开闪烁
-        displayInfo.blink_en = ENBLINK;
-    }
-    else
+    if (target_mode != SETTING_MODE && target_mode != SETPLAYER_LAUNCH_MODE)
     {
-        // 关闭闪烁
-        displayInfo.blink_en = UNBLINK;
+        // 关闭闪烁，设置模式下由各设置项指定闪烁位
+        displayInfo.blink_mask = 0;
     }
     setBuzzer(); // 蜂鸣器工作(模式切换时bee)
     LOG_INFO("Machine switch mode: %d\t->\t%d.\n", console->last_mode, target_mode);
@@ -1038,94 +952,127 @@ static void LoadConsoleSettings(Console_t *consoleSettings)
 }
 
 /**
- * @brief 发牌
- * @param cards 发牌数量
+ * @brief 随机选择一个座位并走较近的方向转过去
  */
-void launchCard(uint16_t cards)
+static void RandomSeat(void)
 {
-    GPIO_PinState last_opto_launch_key, opto_launch_key = RELEASED;
+    DealStep_t step = {DEAL_OP_ROTATE, MOTOR_STOP, 0};
+    uint8_t seat;
 
-    while (cards > 0 && console.main_menu.launchMode != NO_LAUNCH)
+    if (console.main_menu.playerCount == 0)
     {
-        console.main_menu.cardCount++;
-        outMotorForward(&motor[OUTMOTOR]);
-        opto_launch_key = HAL_GPIO_ReadPin(outputOptoKey_GPIO_Port, outputOptoKey_Pin);
-        if (last_opto_launch_key != RELEASED && opto_launch_key == RELEASED)
-        {
-            cards--;
-            motor[OUTMOTOR].cards++;
-            LOG_DEBUG("send one card, output cards: %d\n", motor[OUTMOTOR].cards);
-        }
-        last_opto_launch_key = opto_launch_key;
-        vTaskDelay(pdMS_TO_TICKS(1));
+        console.main_menu.launchMode = NO_LAUNCH;
+        return;
     }
+    seat = (uint8_t)(OptoNowUs() % console.main_menu.playerCount); // 按键时刻的微秒计数作为随机源
+    console.main_menu.launch_card_pos = seat + 1;
+    LOG_INFO("random seat: %d\n", seat + 1);
+    step.arg = DealSeatSector(console.main_menu.playerCount, seat);
+    DealStart(&step, 1, 0, DealDirection(&console.main_menu));
 }
 
 /**
- * @brief 旋转
- * 旋转到指定位置
+ * @brief 座位标定的点动处理
+ * 扇区号未确定时先寻找原点槽，找不到则结束标定
  */
-void RotatePos(uint16_t pos)
+static void CalibrateJog(void)
 {
-    GPIO_PinState last_opto_rotate_key, opto_rotate_key = RELEASED;
+    DealStep_t step = {DEAL_OP_HOME, MOTOR_STOP, 0};
 
-    while (pos > 0 && console.main_menu.launchMode != NO_LAUNCH)
+    if (!motor[ROTATEMOTOR].homed)
     {
-        switch (console.main_menu.dirRotate)
-        {
-        case CLOCKWISE:
-            rotateMotorForward(&motor[ROTATEMOTOR]);
-            break;
-
-        case COUNTER_CLOCKWISE:
-            rotateMotorBackward(&motor[ROTATEMOTOR]);
-            break;
-
-        default:
-            LOG_WARN("Unknown value in the direction of rotation.");
-            break;
-        }
-        opto_rotate_key = HAL_GPIO_ReadPin(rotateOptoKey_GPIO_Port, rotateOptoKey_Pin);
-        if (last_opto_rotate_key != RELEASED && opto_rotate_key == RELEASED)
-        {
-            pos--;
-            LOG_DEBUG("rotate pos: %d\n", pos);
-        }
-        LOG_DEBUG("last pos: %d\t, pos: %d\n", last_opto_rotate_key, opto_rotate_key);
-        last_opto_rotate_key = opto_rotate_key;
-        vTaskDelay(pdMS_TO_TICKS(1));
+        DealStart(&step, 1, 0, MOTOR_FORWARD);
     }
+    else if (cal_jog != 0)
+    {
+        step.op = DEAL_OP_STEP;
+        step.dir = (cal_jog > 0) ? MOTOR_FORWARD : MOTOR_REVERSE;
+        step.arg = 1;
+        DealStart(&step, 1, 0, (MotorDirection_e)step.dir);
+    }
+    cal_jog = 0;
 }
 
 /**
  * @brief 发牌控制模式切换
- * 执行发牌操作
+ * 按发牌模式向发牌引擎提交计划，运动在发牌任务中执行，这里不阻塞
  */
 void WorkModeSwitch(void)
 {
-    KeyState_e last_opto_launch_key = KEY_IDLE;
-    KeyState_e last_opto_rotate_key = KEY_IDLE;
-    uint16_t cards = 0;
+    DealState_e state = DealGetState();
+    DealStep_t step = {DEAL_OP_STEP, MOTOR_FORWARD, 3};
+    bool started;
+    uint8_t script;
 
     switch (console.main_menu.launchMode)
     {
     case NO_LAUNCH:
-        outMotorStop(&motor[OUTMOTOR]);
-        rotateMotorStop(&motor[ROTATEMOTOR]);
+        if (state != DEAL_IDLE)
+        {
+            DealAbort();
+        }
+        else
+        {
+            MotorHeadingSave(); // 学习参数和转盘航向，未变化时不写flash；关机前写flash会无法唤醒，放在这里保存
+        }
         break;
 
     case NORMAL_LAUNCH:
-        console.main_menu.dirRotate = CLOCKWISE; // 顺时针旋转
-        RotatePos(1);
+        if (state == DEAL_IDLE)
+        {
+            script = (uint8_t)(console.main_menu.dealMode - SCRIPT_DEAL);
+            if (console.main_menu.dealMode >= SCRIPT_DEAL && script < deal_script_num)
+            {
+                started = DealStartScript(&console.main_menu, &deal_script[script]);
+            }
+            else
+            {
+                started = DealStartMenu(&console.main_menu);
+            }
+            if (!started)
+            {
+                console.main_menu.launchMode = NO_LAUNCH; // 脚本校验失败
+            }
+        }
+        else if (state == DEAL_DONE || state == DEAL_FAULT)
+        {
+            console.main_menu.launchMode = NO_LAUNCH;
+        }
         break;
 
     case RANDOM_LAUNCH:
+        if (state == DEAL_IDLE)
+        {
+            RandomSeat();
+        }
+        else if (state == DEAL_DONE || state == DEAL_FAULT)
+        {
+            console.main_menu.launchMode = NO_LAUNCH;
+        }
         break;
 
     case TEST_LAUNCH:
-        RotatePos(3);
+        if (state == DEAL_IDLE)
+        {
+            DealStart(&step, 1, 0, MOTOR_FORWARD);
+        }
         console.main_menu.launchMode = NO_LAUNCH;
         break;
+
+    case CALIBRATE_LAUNCH:
+        if (state == DEAL_FAULT)
+        {
+            console.main_menu.launchMode = NO_LAUNCH;
+        }
+        else if (state == DEAL_DONE)
+        {
+            DealAbort(); // 确认点动完成，回到空闲
+        }
+        else if (state == DEAL_IDLE)
+        {
+            CalibrateJog();
+        }
+        break;
     default:
         break;
     }
@@ -1160,6 +1107,29 @@ static void limitValue(uint8_t *value, uint8_t min, uint8_t max)
     }
 }
 
+/**
+ * @brief 按增量调整设置值
+ * 单步时越界回绕(同limitValue)，连发跳步时停在边界，避免按住时来回跳
+ * @param value 待调整数据
+ * @param delta 增量
+ * @param min 最小边界
+ * @param max 最大边界
+ */
+static void adjustValue(uint8_t *value, int8_t delta, uint8_t min, uint8_t max)
+{
+    int16_t target = (int16_t)*value + delta;
+
+    if (delta >= -1 && delta <= 1)
+    {
+        *value += delta;
+        limitValue(value, min, max);
+    }
+    else
+    {
+        *value = (target < min) ? min : (target > max) ? max : (uint8_t)target;
+    }
+}
+
 /**
  * @brief 更新电压
  *      用EWMA平滑ad值实现滤波
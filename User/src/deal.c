@@ -0,0 +1,912 @@
+#include "deal.h"
+#include "bsp_opto.h"
+#include "log.h"
+#include "task.h"
+#include "user_task.h"
+
+
+/* 私有宏 ------------------------------------------------------------------*/
+#define DEAL_REQ_PAUSE 0x01
+#define DEAL_REQ_RESUME 0x02
+#define DEAL_REQ_ABORT 0x04
+#define DEAL_JUMP_MAX (DEAL_PLAN_MAX * 2) // 连续跳转上限，防止计划死循环
+
+/* 私有变量 ------------------------------------------------------------------*/
+// 执行中的计划，只在引擎空闲时由控制台写入
+static DealStep_t deal_plan[DEAL_PLAN_MAX];
+static uint8_t deal_count = 0;
+static bool deal_overflow = false;                  // 编译计划时超出 DEAL_PLAN_MAX
+// 编译脚本时使用
+static MenuItem_t script_menu;                      // 玩家数按脚本修改后的菜单设置
+static uint8_t script_heading = 0;                  // 编译到当前指令时转盘所在扇区
+static uint8_t script_base = 0;                     // 底牌位置
+static uint8_t deal_rounds = 0;                     // DEAL_OP_ROUND 的轮数
+static uint8_t deal_tail = 0;                       // 最后一轮每个 DEAL_OP_BURST 的牌数，0 表示与 arg 相同
+static MotorDirection_e deal_dir = MOTOR_FORWARD;   // 发牌方向，寻找原点槽和较近方向相等时使用
+static volatile DealState_e deal_state = DEAL_IDLE;
+static volatile uint8_t deal_req = 0;               // 控制台请求 DEAL_REQ_*
+
+static uint8_t pc = 0;                  // 当前步骤
+static uint8_t rounds_done = 0;         // 已完成轮数
+static bool step_active = false;        // 当前步骤已开始
+static uint32_t step_start_us = 0;      // 当前步骤开始时刻(us)
+static uint32_t event_tick = 0;         // 最近一次进展(步骤开始或光耦边沿)的时刻，用于超时判断
+static uint32_t arrive_tick = 0;        // 上次转动到位的时刻
+static uint32_t start_tick = 0;         // 计划开始时刻
+static uint32_t deal_cards = 0;         // 本次计划已出的牌数
+static DealStat_t deal_stat[DEAL_OP_NUM];
+
+// 转动步骤状态
+static uint16_t rot_left = 0;           // 剩余边沿数
+static bool rot_cut = false;            // 已提前断电，等待滑行越过目标边沿
+static bool rot_creep = false;          // 停在目标边沿之前，低速补走
+static bool rot_prespin = false;        // 下一步为出牌，到位前预转出牌电机
+static bool rot_homing = false;         // 正在寻找原点槽
+static uint16_t rot_seen = 0;           // 寻找原点槽已越过的边沿数
+static uint32_t rot_settle_end = 0;     // 断电后等待越过目标边沿的截止时刻(us)
+// 出牌步骤状态
+static uint8_t eject_left = 0;          // 剩余牌数
+static uint16_t resume_left = 0;        // 暂停时越过边沿/出牌步骤的剩余量，0 表示从头开始
+
+/* 函数声明 ------------------------------------------------------------------*/
+static bool StepBegin(const DealStep_t *step);
+
+/* 函数体 --------------------------------------------------------------------*/
+/**
+ * @brief 设定的发牌方向
+ * @param menu 菜单设置
+ * @return MotorDirection_e 顺时针为正转
+ */
+MotorDirection_e DealDirection(const MenuItem_t *menu)
+{
+    return (menu->dirRotate == COUNTER_CLOCKWISE) ? MOTOR_REVERSE : MOTOR_FORWARD;
+}
+
+/**
+ * @brief 追加一个计划步骤，超出 DEAL_PLAN_MAX 时丢弃
+ * @param op 操作码
+ * @param dir 方向
+ * @param arg 参数
+ */
+static void DealEmit(DealOp_e op, MotorDirection_e dir, uint8_t arg)
+{
+    if (deal_count < DEAL_PLAN_MAX - 1) // 留一步给 DEAL_OP_END
+    {
+        deal_plan[deal_count].op = op;
+        deal_plan[deal_count].dir = (int8_t)dir;
+        deal_plan[deal_count].arg = arg;
+        deal_count++;
+    }
+    else
+    {
+        deal_overflow = true;
+    }
+}
+
+/**
+ * @brief 底牌位置：座位间最大空档的中点
+ * @param menu 菜单设置
+ * @param heading 没有座位时使用的当前扇区
+ * @return uint8_t 扇区号
+ */
+static uint8_t DealBaseSector(const MenuItem_t *menu, uint8_t heading)
+{
+    MotorDirection_e dir = DealDirection(menu);
+    uint8_t order[SEAT_MAX];
+    uint8_t players, gap;
+
+    players = DealSwayPlan(menu->playerCount, dir, order);
+    if (players == 0)
+    {
+        return heading;
+    }
+    gap = DealSectorGap(DealSeatSector(menu->playerCount, order[players - 1]), DealSeatSector(menu->playerCount, order[0]), dir);
+    gap = (gap == 0) ? ROTATE_SECTORS : gap;
+    return (uint8_t)((DealSeatSector(menu->playerCount, order[players - 1]) + dir * (gap / 2) + ROTATE_SECTORS) % ROTATE_SECTORS);
+}
+
+/**
+ * @brief 计划写好后开始执行
+ * @param rounds 轮数
+ * @param tail 最后一轮每个 DEAL_OP_BURST 的牌数，0 表示与 arg 相同
+ * @param dir 发牌方向
+ */
+static void DealLaunch(uint8_t rounds, uint8_t tail, MotorDirection_e dir)
+{
+    deal_plan[deal_count].op = DEAL_OP_END;
+    deal_plan[deal_count].dir = MOTOR_STOP;
+    deal_plan[deal_count].arg = 0;
+    deal_rounds = rounds;
+    deal_tail = tail;
+    deal_dir = dir;
+    pc = 0;
+    rounds_done = 0;
+    step_active = false;
+    resume_left = 0;
+    deal_cards = 0;
+    deal_req = 0;
+    start_tick = xTaskGetTickCount();
+    deal_state = DEAL_RUN; // 计划写完后再发布
+    DealTaskNotify();
+}
+
+/**
+ * @brief 执行给定的步骤，末尾自动补 DEAL_OP_END
+ * @param step 步骤
+ * @param count 步数
+ * @param rounds DEAL_OP_ROUND 的轮数
+ * @param dir 发牌方向
+ * @return true 已开始
+ */
+bool DealStart(const DealStep_t *step, uint8_t count, uint8_t rounds, MotorDirection_e dir)
+{
+    if (deal_state != DEAL_IDLE || count >= DEAL_PLAN_MAX)
+    {
+        return false;
+    }
+    for (deal_count = 0; deal_count < count; deal_count++)
+    {
+        deal_plan[deal_count] = step[deal_count];
+    }
+    DealLaunch(rounds, 0, dir);
+    return true;
+}
+
+/**
+ * @brief 按菜单设置编译发牌计划并开始执行
+ * 底牌发到座位间最大空档的中点；玩家部分为一轮的循环体，旋转发牌沿发牌方向依次转过各座位，
+ * 摆动发牌(2/3人)的循环体为来回两趟，端点处换向前等待制动和死区时间
+ * 每个座位每次停留连发 burstCount 张，轮数为 cardCount/burstCount 向上取整，最后一轮只补足剩余的牌
+ * @param menu 菜单设置
+ * @return true 已开始
+ */
+bool DealStartMenu(const MenuItem_t *menu)
+{
+    MotorDirection_e dir = DealDirection(menu), fwd = dir;
+    uint8_t order[SEAT_MAX];
+    uint8_t players, heading, base, body, tmp, i;
+    uint8_t burst = (menu->burstCount > 1) ? menu->burstCount : 1;
+    uint8_t rounds = (uint8_t)((menu->cardCount + burst - 1) / burst);
+    uint8_t dwell = (uint8_t)((MotorGetProfile(ROTATEMOTOR)->brake_ms + SWAY_DEAD_TIME + DEAL_DWELL_UNIT - 1) / DEAL_DWELL_UNIT);
+
+    if (deal_state != DEAL_IDLE)
+    {
+        return false;
+    }
+    deal_count = 0;
+    deal_overflow = false;
+    players = (menu->playerCount > SEAT_MAX) ? SEAT_MAX : menu->playerCount;
+    heading = (uint8_t)motor[ROTATEMOTOR].current_pos;
+
+    DealEmit(DEAL_OP_HOME, MOTOR_STOP, 0);
+    base = DealBaseSector(menu, heading);
+    if (menu->deckCount > 0 && menu->dealOrder == BOTTOM_FIRST_DEAL)
+    {
+        DealEmit(DEAL_OP_ROTATE, MOTOR_STOP, base);
+        DealEmit(DEAL_OP_EJECT, MOTOR_STOP, menu->deckCount);
+        heading = base;
+    }
+
+    if (players > 0 && menu->cardCount > 0)
+    {
+        if (menu->dealMode == SWAY_DEAL && (players == 2 || players == 3))
+        {
+            DealSwayPlan(menu->playerCount, dir, order);
+            // 从离当前航向较近的一端开始
+            if (DealSectorGap(heading, DealSeatSector(menu->playerCount, order[players - 1]),
+                              DealSectorShortest(heading, DealSeatSector(menu->playerCount, order[players - 1]), dir)) <
+                DealSectorGap(heading, DealSeatSector(menu->playerCount, order[0]),
+                              DealSectorShortest(heading, DealSeatSector(menu->playerCount, order[0]), dir)))
+            {
+                for (i = 0; i < players / 2; i++)
+                {
+                    tmp = order[i];
+                    order[i] = order[players - 1 - i];
+                    order[players - 1 - i] = tmp;
+                }
+                fwd = (MotorDirection_e)-dir;
+            }
+            DealEmit(DEAL_OP_ROTATE, MOTOR_STOP, DealSeatSector(menu->playerCount, order[0]));
+            body = deal_count;
+            DealEmit(DEAL_OP_BURST, MOTOR_STOP, burst);
+            for (i = 1; i < players; i++)
+            {
+                if (i == 1)
+                {
+                    DealEmit(DEAL_OP_DWELL, MOTOR_STOP, dwell);
+                }
+                DealEmit(DEAL_OP_ROTATE, fwd, DealSeatSector(menu->playerCount, order[i]));
+                DealEmit(DEAL_OP_BURST, MOTOR_STOP, burst);
+            }
+            DealEmit(DEAL_OP_ROUND, MOTOR_STOP, 0);
+            DealEmit(DEAL_OP_BURST, MOTOR_STOP, burst); // 端点座位连续两次，不需要转动
+            for (i = players - 1; i > 0; i--)
+            {
+                if (i == players - 1)
+                {
+                    DealEmit(DEAL_OP_DWELL, MOTOR_STOP, dwell);
+                }
+                DealEmit(DEAL_OP_ROTATE, (MotorDirection_e)-fwd, DealSeatSector(menu->playerCount, order[i - 1]));
+                DealEmit(DEAL_OP_BURST, MOTOR_STOP, burst);
+            }
+            DealEmit(DEAL_OP_ROUND, MOTOR_STOP, 0);
+        }
+        else
+        {
+            DealSeatPlan(menu->playerCount, dir, heading, order);
+            DealEmit(DEAL_OP_ROTATE, MOTOR_STOP, DealSeatSector(menu->playerCount, order[0]));
+            body = deal_count;
+            for (i = 0; i < players; i++)
+            {
+                DealEmit(DEAL_OP_BURST, MOTOR_STOP, burst);
+                if (i + 1 < players)
+                {
+                    DealEmit(DEAL_OP_ROTATE, dir, DealSeatSector(menu->playerCount, order[i + 1]));
+                }
+            }
+            DealEmit(DEAL_OP_ROUND, MOTOR_STOP, 0);
+            DealEmit(DEAL_OP_ROTATE, dir, DealSeatSector(menu->playerCount, order[0]));
+        }
+        DealEmit(DEAL_OP_LOOP, MOTOR_STOP, body);
+        // 轮数已满时跳出循环体
+        for (i = body; i < deal_count; i++)
+        {
+            if (deal_plan[i].op == DEAL_OP_ROUND)
+            {
+                deal_plan[i].arg = deal_count;
+            }
+        }
+    }
+
+    if (menu->deckCount > 0 && menu->dealOrder == BOTTOM_LAST_DEAL)
+    {
+        DealEmit(DEAL_OP_ROTATE, MOTOR_STOP, base);
+        DealEmit(DEAL_OP_EJECT, MOTOR_STOP, menu->deckCount);
+    }
+    if (deal_overflow)
+    {
+        LOG_WARN("deal plan exceeds %d steps\n", DEAL_PLAN_MAX);
+        deal_count = 0;
+        return false;
+    }
+    LOG_DEBUG("deal plan: %d steps, %d rounds x %d cards\n", deal_count, rounds, burst);
+    DealLaunch(rounds, (uint8_t)(menu->cardCount - (rounds - 1) * burst), dir);
+    return true;
+}
+
+/**
+ * @brief 把脚本的一段指令编译成计划步骤
+ * 最外层的 REPEAT 编译成 DEAL_OP_COUNT/ROUND/LOOP 循环，内层 REPEAT 和 FOR_EACH_SEAT 展开，
+ * 执行时与手写计划的步骤相同，每张牌没有额外的解释开销
+ * @param script 脚本，已通过 DealScriptCheck
+ * @param i 开始位置
+ * @param end 结束位置(不含)
+ * @param looped 已在循环体内
+ */
+static void ScriptCompile(const DealScript_t *script, uint8_t i, uint8_t end, bool looped)
+{
+    uint8_t order[SEAT_MAX];
+    uint8_t op, arg, stop, body, leave, players, k;
+
+    for (; i < end && !deal_overflow; i += 2)
+    {
+        op = script->code[i];
+        arg = script->code[i + 1];
+        switch (op)
+        {
+        case DS_OP_ROTATE_TO:
+            script_heading = (arg == DS_SEAT_BASE) ? script_base : DealSeatSector(script_menu.playerCount, arg);
+            DealEmit(DEAL_OP_ROTATE, MOTOR_STOP, script_heading);
+            break;
+
+        case DS_OP_EJECT:
+            DealEmit(DEAL_OP_EJECT, MOTOR_STOP, arg);
+            break;
+
+        case DS_OP_BASE_PILE:
+            script_heading = script_base;
+            DealEmit(DEAL_OP_ROTATE, MOTOR_STOP, script_base);
+            DealEmit(DEAL_OP_EJECT, MOTOR_STOP, arg);
+            break;
+
+        case DS_OP_FOR_EACH_SEAT:
+            // 首个座位走较近的方向，之后沿发牌方向依次转过各座位
+            stop = DealScriptBlockEnd(script, i);
+            players = DealSeatPlan(script_menu.playerCount, DealDirection(&script_menu), script_heading, order);
+            for (k = 0; k < players; k++)
+            {
+                script_heading = DealSeatSector(script_menu.playerCount, order[k]);
+                DealEmit(DEAL_OP_ROTATE, (k == 0) ? MOTOR_STOP : DealDirection(&script_menu), script_heading);
+                ScriptCompile(script, i + 2, stop, looped);
+            }
+            i = stop;
+            break;
+
+        case DS_OP_REPEAT:
+            stop = DealScriptBlockEnd(script, i);
+            if (!looped && arg > 1)
+            {
+                // 计划长度与重复次数无关
+                DealEmit(DEAL_OP_COUNT, MOTOR_STOP, arg);
+                body = deal_count;
+                ScriptCompile(script, i + 2, stop, true);
+                leave = deal_count;
+                DealEmit(DEAL_OP_ROUND, MOTOR_STOP, 0);
+                DealEmit(DEAL_OP_LOOP, MOTOR_STOP, body);
+                if (!deal_overflow)
+                {
+                    deal_plan[leave].arg = deal_count;
+                }
+            }
+            else
+            {
+                for (k = 0; k < arg; k++)
+                {
+                    ScriptCompile(script, i + 2, stop, looped);
+                }
+            }
+            i = stop;
+            break;
+
+        default: // DS_OP_END
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 校验发牌脚本，编译成计划并开始执行
+ * @param menu 菜单设置，提供发牌方向、玩家数(脚本未指定时)和座位表
+ * @param script 脚本
+ * @return true 已开始
+ */
+bool DealStartScript(const MenuItem_t *menu, const DealScript_t *script)
+{
+    uint16_t seat_cards[SEAT_MAX], base_cards;
+    DealScriptErr_e err;
+
+    if (deal_state != DEAL_IDLE)
+    {
+        return false;
+    }
+    err = DealScriptCheck(script, menu->playerCount, seat_cards, &base_cards);
+    if (err != DS_OK)
+    {
+        LOG_WARN("deal script rejected: %d\n", err);
+        return false;
+    }
+    script_menu = *menu;
+    script_menu.playerCount = DealScriptPlayers(script, menu->playerCount);
+    script_heading = (uint8_t)motor[ROTATEMOTOR].current_pos;
+    script_base = DealBaseSector(&script_menu, script_heading);
+
+    deal_count = 0;
+    deal_overflow = false;
+    DealEmit(DEAL_OP_HOME, MOTOR_STOP, 0);
+    ScriptCompile(script, 0, script->size, false);
+    if (deal_overflow)
+    {
+        LOG_WARN("deal script exceeds %d steps\n", DEAL_PLAN_MAX);
+        deal_count = 0;
+        return false;
+    }
+    LOG_DEBUG("deal script: %d players x %d cards, base %d, %d steps\n",
+              script_menu.playerCount, seat_cards[0], base_cards, deal_count);
+    DealLaunch(0, 0, DealDirection(menu));
+    return true;
+}
+
+/**
+ * @brief 暂停，当前步骤的进度保留
+ */
+void DealPause(void)
+{
+    if (deal_state == DEAL_RUN)
+    {
+        __disable_irq();
+        deal_req |= DEAL_REQ_PAUSE;
+        __enable_irq();
+        DealTaskNotify();
+    }
+}
+
+/**
+ * @brief 从暂停处继续
+ */
+void DealResume(void)
+{
+    __disable_irq();
+    deal_req |= DEAL_REQ_RESUME;
+    __enable_irq();
+    DealTaskNotify();
+}
+
+/**
+ * @brief 放弃计划，停止电机回到空闲；也用于计划完成或故障后的确认
+ */
+void DealAbort(void)
+{
+    __disable_irq();
+    deal_req |= DEAL_REQ_ABORT;
+    __enable_irq();
+    DealTaskNotify();
+}
+
+/**
+ * @brief 引擎状态
+ */
+DealState_e DealGetState(void)
+{
+    return deal_state;
+}
+
+/**
+ * @brief 本次计划已出的牌数
+ */
+uint32_t DealCards(void)
+{
+    return deal_cards;
+}
+
+/**
+ * @brief 步骤耗时统计
+ * @param op 操作码
+ */
+const DealStat_t *DealGetStat(DealOp_e op)
+{
+    return &deal_stat[(op < DEAL_OP_NUM) ? op : DEAL_OP_END];
+}
+
+/**
+ * @brief 停止两个电机并关闭出牌口互锁
+ */
+static void DealStopMotors(void)
+{
+    rotateMotorStop(&motor[ROTATEMOTOR]);
+    outMotorStop(&motor[OUTMOTOR]);
+    OptoGuardSet(false);
+}
+
+/**
+ * @brief 计入停止期间(滑行、手动拨动)的旋转边沿
+ * 这些边沿只更新扇区号，不参与速度估计和原点槽识别
+ */
+static void DealDrainRotate(void)
+{
+    OptoEdge_t edge;
+
+    while (OptoEdgeGet(OPTO_ROTATE, &edge))
+    {
+        MotorPredictStart(ROTATEMOTOR);
+        MotorEdge(&motor[ROTATEMOTOR], edge.us, edge.width);
+    }
+}
+
+/**
+ * @brief 从指定步骤起实际执行的下一个步骤
+ * 按执行时的规则跟随 DEAL_OP_LOOP/ROUND/COUNT 的跳转，不修改轮数
+ * @param i 起始步骤
+ * @return DealOp_e 下一个非控制步骤的操作码，跳转过多或越界时为 DEAL_OP_END
+ */
+static DealOp_e DealNextOp(uint8_t i)
+{
+    uint8_t rounds = deal_rounds, done = rounds_done, jumps = 0;
+
+    while (i <= deal_count && jumps++ <= DEAL_JUMP_MAX)
+    {
+        switch (deal_plan[i].op)
+        {
+        case DEAL_OP_LOOP:
+            i = deal_plan[i].arg;
+            break;
+        case DEAL_OP_COUNT:
+            rounds = deal_plan[i].arg;
+            done = 0;
+            i++;
+            break;
+        case DEAL_OP_ROUND:
+            i = (++done >= rounds) ? deal_plan[i].arg : i + 1;
+            break;
+        default:
+            return (DealOp_e)deal_plan[i].op;
+        }
+    }
+    return DEAL_OP_END;
+}
+
+/**
+ * @brief 开始转动
+ * @param dir 转动方向
+ * @param pos 需越过的边沿数
+ */
+static void RotateBegin(MotorDirection_e dir, uint16_t pos)
+{
+    DealOp_e next;
+
+    rot_left = pos;
+    rot_cut = false;
+    rot_creep = false;
+    next = DealNextOp(pc + 1); // 循环体末尾的转动之后是 DEAL_OP_LOOP，跟随跳转找到出牌步骤
+    rot_prespin = (next == DEAL_OP_EJECT || next == DEAL_OP_BURST);
+    MotorPredictStart(ROTATEMOTOR);
+    MotorSetSpeed(&motor[ROTATEMOTOR], dir, MotorGetProfile(ROTATEMOTOR)->max_duty);
+}
+
+/**
+ * @brief 转动进度：计数边沿，最后一个间距内预转出牌电机并按预测提前断电
+ * @param wait 输出：下次需要处理的时间(tick)
+ * @return true 到位
+ */
+static bool RotatePoll(TickType_t *wait)
+{
+    OptoEdge_t edge;
+    uint32_t now;
+
+    while (rot_left > 0 && OptoEdgeGet(OPTO_ROTATE, &edge))
+    {
+        event_tick = xTaskGetTickCount();
+        MotorEdge(&motor[ROTATEMOTOR], edge.us, edge.width);
+        if (rot_homing)
+        {
+            if (motor[ROTATEMOTOR].homed)
+            {
+                break;
+            }
+            if (++rot_seen >= ROTATE_SECTORS * 2U)
+            {
+                LOG_WARN("rotate home slot not found\n");
+                rot_left = 0;
+                deal_state = DEAL_FAULT;
+                return false;
+            }
+            continue;
+        }
+        rot_left--;
+        if (rot_cut && rot_left == 0)
+        {
+            MotorPredictLearn(ROTATEMOTOR, edge.us, true);
+        }
+    }
+    if (rot_homing && motor[ROTATEMOTOR].homed)
+    {
+        // 找到原点槽后按确定的扇区号重新计算，电机不停
+        rot_homing = false;
+        LOG_INFO("rotate homed at sector %d\n", motor[ROTATEMOTOR].current_pos);
+        if (StepBegin(&deal_plan[pc]))
+        {
+            rot_left = 0;
+        }
+    }
+
+    if (rot_left == 0)
+    {
+        if (!rot_cut)
+        {
+            rotateMotorStop(&motor[ROTATEMOTOR]);
+        }
+        OptoGuardSet(false); // 已到位，预转中被互锁制动的牌在出牌步骤继续
+        arrive_tick = xTaskGetTickCount();
+        return true;
+    }
+
+    now = OptoNowUs();
+    if (rot_prespin && rot_left == 1 && (rot_cut || (motor[ROTATEMOTOR].predict.period != 0 &&
+        now - motor[ROTATEMOTOR].state.edge_us + DEAL_PRESPIN_TIME * 1000U >= motor[ROTATEMOTOR].predict.period)))
+    {
+        // 预计到位前 DEAL_PRESPIN_TIME 起动出牌电机，牌头先于到位到达出牌口时由互锁制动
+        rot_prespin = false;
+        OptoFlush(OPTO_OUTPUT);
+        OptoGuardSet(true);
+        outMotorForward(&motor[OUTMOTOR]);
+    }
+    if (!rot_homing && rot_left == 1 && !rot_cut && !rot_creep && MotorPredictStopDue(ROTATEMOTOR, now))
+    {
+        rotateMotorStop(&motor[ROTATEMOTOR]);
+        rot_cut = true;
+        rot_settle_end = now + MotorPredictSettleMs(ROTATEMOTOR) * 1000U;
+    }
+    else if (rot_cut && (int32_t)(now - rot_settle_end) >= 0)
+    {
+        MotorPredictLearn(ROTATEMOTOR, now, false);
+        LOG_DEBUG("rotate undershoot, creep to seat\n");
+        rot_cut = false;
+        rot_creep = true;
+        MotorSetSpeed(&motor[ROTATEMOTOR], motor[ROTATEMOTOR].state.travel, MotorGetProfile(ROTATEMOTOR)->min_duty);
+    }
+    if (rot_left == 1 || rot_cut)
+    {
+        *wait = 1; // 最后一个间距内每个节拍估算一次
+    }
+    return false;
+}
+
+/**
+ * @brief 出牌进度：牌尾离开出牌光耦计一张，最后一张后立即制动出牌电机
+ * @return true 出牌完成
+ */
+static bool EjectPoll(void)
+{
+    OptoEdge_t edge;
+
+    while (eject_left > 0 && OptoEdgeGet(OPTO_OUTPUT, &edge))
+    {
+        event_tick = xTaskGetTickCount();
+        eject_left--;
+        deal_cards++;
+        MotorEdge(&motor[OUTMOTOR], edge.us, edge.width);
+    }
+    if (eject_left == 0)
+    {
+        outMotorStop(&motor[OUTMOTOR]);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 开始一个步骤
+ * @param step 步骤
+ * @return true 不需要等待，已完成
+ */
+static bool StepBegin(const DealStep_t *step)
+{
+    uint8_t from;
+    uint16_t left;
+    MotorDirection_e dir;
+
+    switch (step->op)
+    {
+    case DEAL_OP_HOME:
+    case DEAL_OP_ROTATE:
+        DealDrainRotate();
+        if (!motor[ROTATEMOTOR].homed)
+        {
+            rot_homing = true;
+            rot_seen = 0;
+            RotateBegin(deal_dir, 0xFFFF);
+            rot_prespin = false;
+            return false;
+        }
+        from = (uint8_t)motor[ROTATEMOTOR].current_pos;
+        if (step->op == DEAL_OP_HOME || step->arg >= ROTATE_SECTORS || from == step->arg)
+        {
+            return true;
+        }
+        dir = (step->dir != MOTOR_STOP) ? (MotorDirection_e)step->dir : DealSectorShortest(from, step->arg, deal_dir);
+        RotateBegin(dir, DealSectorGap(from, step->arg, dir));
+        return false;
+
+    case DEAL_OP_STEP:
+        DealDrainRotate();
+        left = (resume_left != 0) ? resume_left : step->arg;
+        resume_left = 0;
+        if (left == 0)
+        {
+            return true;
+        }
+        RotateBegin((step->dir != MOTOR_STOP) ? (MotorDirection_e)step->dir : deal_dir, left);
+        return false;
+
+    case DEAL_OP_EJECT:
+    case DEAL_OP_BURST:
+        left = step->arg;
+        if (step->op == DEAL_OP_BURST && deal_tail != 0 && rounds_done + 1U >= deal_rounds)
+        {
+            left = deal_tail; // 最后一轮只补足剩余的牌
+        }
+        left = (resume_left != 0) ? resume_left : left;
+        resume_left = 0;
+        if (left == 0)
+        {
+            return true;
+        }
+        if (motor[OUTMOTOR].req_dir == MOTOR_STOP)
+        {
+            OptoFlush(OPTO_OUTPUT); // 已预转时缓冲中可能已有本座位的牌，不能丢弃
+        }
+        eject_left = (uint8_t)left;
+        outMotorForward(&motor[OUTMOTOR]);
+        return false;
+
+    case DEAL_OP_DWELL:
+        return false;
+
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief 推进当前步骤
+ * @param step 步骤
+ * @param wait 输出：下次需要处理的时间(tick)
+ * @return true 步骤完成
+ */
+static bool StepPoll(const DealStep_t *step, TickType_t *wait)
+{
+    uint32_t elapsed;
+
+    if (step->op == DEAL_OP_DWELL)
+    {
+        elapsed = xTaskGetTickCount() - arrive_tick;
+        if (elapsed >= pdMS_TO_TICKS(step->arg * DEAL_DWELL_UNIT))
+        {
+            return true;
+        }
+        *wait = pdMS_TO_TICKS(step->arg * DEAL_DWELL_UNIT) - elapsed;
+        return false;
+    }
+    if ((step->op == DEAL_OP_EJECT || step->op == DEAL_OP_BURST) ? EjectPoll() : RotatePoll(wait))
+    {
+        return true;
+    }
+    if (deal_state != DEAL_RUN)
+    {
+        return false;
+    }
+    // 电机卡住、缺牌或光耦失效
+    elapsed = xTaskGetTickCount() - event_tick;
+    if (elapsed >= pdMS_TO_TICKS(DEAL_STALL_MS))
+    {
+        LOG_WARN("deal step %d (op %d) stalled\n", pc, step->op);
+        deal_state = DEAL_FAULT;
+        return false;
+    }
+    if (pdMS_TO_TICKS(DEAL_STALL_MS) - elapsed < *wait)
+    {
+        *wait = pdMS_TO_TICKS(DEAL_STALL_MS) - elapsed;
+    }
+    return false;
+}
+
+/**
+ * @brief 步骤完成，记录耗时
+ * @param step 步骤
+ */
+static void StepDone(const DealStep_t *step)
+{
+    DealStat_t *stat = &deal_stat[step->op];
+    uint32_t us = OptoNowUs() - step_start_us;
+
+    stat->count++;
+    stat->last_us = us;
+    stat->total_us += us;
+    if (us > stat->max_us)
+    {
+        stat->max_us = us;
+    }
+    LOG_DEBUG("deal step %d op %d: %u us\n", pc, step->op, us);
+    step_active = false;
+    pc++;
+}
+
+/**
+ * @brief 处理控制台请求
+ */
+static void DealRequest(void)
+{
+    uint8_t req;
+    const DealStep_t *step = &deal_plan[pc];
+
+    __disable_irq();
+    req = deal_req;
+    deal_req = 0;
+    __enable_irq();
+
+    if (req & DEAL_REQ_ABORT)
+    {
+        DealStopMotors();
+        step_active = false;
+        rot_homing = false;
+        resume_left = 0;
+        deal_state = DEAL_IDLE;
+        return;
+    }
+    if ((req & DEAL_REQ_PAUSE) && deal_state == DEAL_RUN)
+    {
+        DealStopMotors();
+        if (step_active)
+        {
+            // 记下剩余量，恢复时重新开始该步骤；计划本身不改，循环体下一轮仍按原参数执行；
+            // 转到扇区的步骤按当前扇区重新计算
+            if (step->op == DEAL_OP_STEP && !rot_homing)
+            {
+                resume_left = rot_left;
+            }
+            else if (step->op == DEAL_OP_EJECT || step->op == DEAL_OP_BURST)
+            {
+                resume_left = eject_left;
+            }
+            step_active = false;
+            rot_homing = false;
+        }
+        deal_state = DEAL_PAUSE;
+    }
+    if ((req & DEAL_REQ_RESUME) && deal_state == DEAL_PAUSE)
+    {
+        deal_state = DEAL_RUN;
+    }
+}
+
+/**
+ * @brief 发牌引擎，在发牌任务中调用
+ * 由光耦边沿、控制台请求或超时唤醒，推进计划直到需要等待事件
+ * @return TickType_t 最长等待时间
+ */
+TickType_t DealRun(void)
+{
+    TickType_t wait = portMAX_DELAY;
+    const DealStep_t *step;
+    uint8_t jumps = 0;
+    bool done;
+
+    DealRequest();
+    while (deal_state == DEAL_RUN)
+    {
+        if (pc > deal_count)
+        {
+            LOG_WARN("deal plan jumps out of range\n");
+            deal_state = DEAL_FAULT;
+            break;
+        }
+        step = &deal_plan[pc];
+        if (!step_active)
+        {
+            if (step->op == DEAL_OP_END)
+            {
+                deal_state = DEAL_DONE;
+                LOG_INFO("dealt %d cards, %d cards/min\n", deal_cards,
+                         deal_cards * 60000U / (xTaskGetTickCount() - start_tick + 1));
+                break;
+            }
+            if (step->op == DEAL_OP_ROUND || step->op == DEAL_OP_LOOP || step->op == DEAL_OP_COUNT)
+            {
+                if (++jumps > DEAL_JUMP_MAX)
+                {
+                    LOG_WARN("deal plan makes no progress\n");
+                    deal_state = DEAL_FAULT;
+                    break;
+                }
+                if (step->op == DEAL_OP_LOOP)
+                {
+                    pc = step->arg;
+                }
+                else if (step->op == DEAL_OP_COUNT)
+                {
+                    deal_rounds = step->arg;
+                    rounds_done = 0;
+                    pc++;
+                }
+                else
+                {
+                    pc = (++rounds_done >= deal_rounds) ? step->arg : pc + 1;
+                }
+                continue;
+            }
+            step_active = true;
+            step_start_us = OptoNowUs();
+            event_tick = xTaskGetTickCount();
+            done = StepBegin(step) || StepPoll(step, &wait);
+        }
+        else
+        {
+            done = StepPoll(step, &wait);
+        }
+        if (!done)
+        {
+            break;
+        }
+        StepDone(step);
+        wait = portMAX_DELAY;
+    }
+    if (deal_state == DEAL_FAULT)
+    {
+        DealStopMotors();
+        step_active = false;
+    }
+    if (deal_state != DEAL_RUN)
+    {
+        DealDrainRotate(); // 空闲/暂停时滑行或手动拨动的边沿，及时计入扇区号，避免缓冲溢出
+    }
+    return (deal_state == DEAL_RUN) ? wait : portMAX_DELAY;
+}
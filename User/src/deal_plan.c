@@ -0,0 +1,142 @@
+#include "deal_plan.h"
+
+// 座位规划：只依赖座位表(MotorSeatGet)，不访问HAL和RTOS，可在主机上测试
+
+/* 函数体 --------------------------------------------------------------------*/
+/**
+ * @brief 沿指定方向从一个扇区转到另一个扇区需越过的边沿数
+ * @param from 起始扇区
+ * @param to 目标扇区
+ * @param dir 转动方向
+ * @return uint8_t 边沿数 0 ~ ROTATE_SECTORS-1
+ */
+uint8_t DealSectorGap(uint8_t from, uint8_t to, MotorDirection_e dir)
+{
+    if (dir == MOTOR_REVERSE)
+    {
+        return (uint8_t)((from + ROTATE_SECTORS - to) % ROTATE_SECTORS);
+    }
+    return (uint8_t)((to + ROTATE_SECTORS - from) % ROTATE_SECTORS);
+}
+
+/**
+ * @brief 两个扇区之间较近的转动方向
+ * @param from 起始扇区
+ * @param to 目标扇区
+ * @param prefer 距离相等时的方向
+ * @return MotorDirection_e 转动方向
+ */
+MotorDirection_e DealSectorShortest(uint8_t from, uint8_t to, MotorDirection_e prefer)
+{
+    MotorDirection_e other = (MotorDirection_e)-prefer;
+
+    return (DealSectorGap(from, to, other) < DealSectorGap(from, to, prefer)) ? other : prefer;
+}
+
+/**
+ * @brief 座位所在扇区
+ * 当前玩家数已标定时按座位表，否则按玩家数均分一周
+ * @param players 玩家数
+ * @param seat 座位 0 ~ players-1
+ * @return uint8_t 扇区号，没有玩家时为0
+ */
+uint8_t DealSeatSector(uint8_t players, uint8_t seat)
+{
+    uint8_t sector = MotorSeatGet(players, seat);
+
+    if (sector == SEAT_NONE)
+    {
+        sector = (players == 0) ? 0 : (uint8_t)(seat * ROTATE_SECTORS / players);
+    }
+    return sector;
+}
+
+/**
+ * @brief 规划一轮旋转发牌的座位顺序
+ * 各座位按发牌方向排列，一轮的行程为"当前航向到首个座位的较近距离 + 一周 - 末座位到首座位的间隔"，
+ * 取行程最短的座位作为首个座位
+ * @param players 玩家数，超过 SEAT_MAX 时按 SEAT_MAX
+ * @param dir 发牌方向
+ * @param heading 当前扇区
+ * @param order 输出：座位顺序
+ * @return uint8_t 座位数
+ */
+uint8_t DealSeatPlan(uint8_t players, MotorDirection_e dir, uint8_t heading, uint8_t order[SEAT_MAX])
+{
+    uint8_t count = (players > SEAT_MAX) ? SEAT_MAX : players;
+    uint8_t gap[SEAT_MAX], sorted[SEAT_MAX];
+    uint8_t i, j, sector, near, best = 0;
+    uint16_t travel, best_travel = 0xFFFF;
+
+    // 按沿发牌方向离当前航向的距离插入排序
+    for (i = 0; i < count; i++)
+    {
+        gap[i] = DealSectorGap(heading, DealSeatSector(players, i), dir);
+        for (j = i; j > 0 && gap[sorted[j - 1]] > gap[i]; j--)
+        {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = i;
+    }
+    for (i = 0; i < count; i++)
+    {
+        sector = DealSeatSector(players, sorted[i]);
+        near = DealSectorGap(heading, sector, DealSectorShortest(heading, sector, dir));
+        travel = near + ROTATE_SECTORS -
+                 DealSectorGap(DealSeatSector(players, sorted[(i + count - 1) % count]), sector, dir);
+        if (travel < best_travel)
+        {
+            best_travel = travel;
+            best = i;
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        order[i] = sorted[(best + i) % count];
+    }
+    return count;
+}
+
+/**
+ * @brief 规划摆动发牌的座位顺序
+ * 各座位按发牌方向排列，以相邻座位间最大的空档为界，摆动只在空档以外的范围内来回
+ * @param players 玩家数，超过 SEAT_MAX 时按 SEAT_MAX
+ * @param dir 发牌方向
+ * @param order 输出：从一端到另一端的座位顺序(沿发牌方向)
+ * @return uint8_t 座位数
+ */
+uint8_t DealSwayPlan(uint8_t players, MotorDirection_e dir, uint8_t order[SEAT_MAX])
+{
+    uint8_t count = (players > SEAT_MAX) ? SEAT_MAX : players;
+    uint8_t sorted[SEAT_MAX];
+    uint8_t i, j, gap, best_gap = 0, best = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        for (j = i; j > 0 && DealSectorGap(0, DealSeatSector(players, sorted[j - 1]), dir) >
+                                 DealSectorGap(0, DealSeatSector(players, i), dir); j--)
+        {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = i;
+    }
+    for (i = 0; i < count; i++)
+    {
+        gap = DealSectorGap(DealSeatSector(players, sorted[(i + count - 1) % count]),
+                            DealSeatSector(players, sorted[i]), dir);
+        if (gap == 0)
+        {
+            gap = ROTATE_SECTORS; // 只有一个有效位置时整周都是空档
+        }
+        if (gap > best_gap)
+        {
+            best_gap = gap;
+            best = i;
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        order[i] = sorted[(best + i) % count];
+    }
+    return count;
+}
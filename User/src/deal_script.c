@@ -0,0 +1,230 @@
+#include "deal_script.h"
+
+
+/* 私有宏 ------------------------------------------------------------------*/
+#define DS_POS_NONE 0xFEU   // 校验时位置未确定
+
+/* 内置脚本 ------------------------------------------------------------------*/
+// 斗地主：3人各17张，底牌3张最后发
+static const uint8_t script_doudizhu[] = {
+    DS_REPEAT(17),
+        DS_FOR_EACH_SEAT(),
+            DS_EJECT(1),
+        DS_NEXT(),
+    DS_NEXT(),
+    DS_BASE_PILE(3),
+    DS_END(),
+};
+
+// 掼蛋：两副牌4人各27张，没有底牌
+static const uint8_t script_guandan[] = {
+    DS_REPEAT(27),
+        DS_FOR_EACH_SEAT(),
+            DS_EJECT(1),
+        DS_NEXT(),
+    DS_NEXT(),
+    DS_END(),
+};
+
+// 德州扑克：玩家数跟随菜单，每人2张底牌，5张公共牌发到中间
+static const uint8_t script_holdem[] = {
+    DS_REPEAT(2),
+        DS_FOR_EACH_SEAT(),
+            DS_EJECT(1),
+        DS_NEXT(),
+    DS_NEXT(),
+    DS_BASE_PILE(5),
+    DS_END(),
+};
+
+const DealScript_t deal_script[] = {
+    {script_doudizhu, sizeof(script_doudizhu), 3, 17, 3},
+    {script_guandan, sizeof(script_guandan), 4, 27, 0},
+    {script_holdem, sizeof(script_holdem), 0, 2, 5},
+};
+const uint8_t deal_script_num = sizeof(deal_script) / sizeof(deal_script[0]);
+
+/* 函数体 --------------------------------------------------------------------*/
+/**
+ * @brief 脚本实际使用的玩家数
+ * @param script 脚本
+ * @param players 菜单设置的玩家数
+ * @return uint8_t 玩家数 0 ~ SEAT_MAX
+ */
+uint8_t DealScriptPlayers(const DealScript_t *script, uint8_t players)
+{
+    if (script->players != 0)
+    {
+        players = script->players;
+    }
+    return (players > SEAT_MAX) ? SEAT_MAX : players;
+}
+
+/**
+ * @brief 查找块的结束指令
+ * @param script 脚本
+ * @param i 块开始指令(REPEAT/FOR_EACH_SEAT)的位置
+ * @return uint8_t 配对的 DS_OP_NEXT 的位置，找不到时返回 size
+ */
+uint8_t DealScriptBlockEnd(const DealScript_t *script, uint8_t i)
+{
+    uint8_t depth = 0;
+
+    for (; i + 1U < script->size; i += 2)
+    {
+        if (script->code[i] == DS_OP_REPEAT || script->code[i] == DS_OP_FOR_EACH_SEAT)
+        {
+            depth++;
+        }
+        else if (script->code[i] == DS_OP_NEXT && --depth == 0)
+        {
+            return i;
+        }
+        else if (script->code[i] == DS_OP_END)
+        {
+            break;
+        }
+    }
+    return script->size;
+}
+
+/**
+ * @brief 累加牌数，超出16位时饱和
+ */
+static void DealScriptAdd(uint16_t *count, uint32_t cards)
+{
+    cards += *count;
+    *count = (cards > 0xFFFFU) ? 0xFFFFU : (uint16_t)cards;
+}
+
+/**
+ * @brief 静态校验脚本并统计各位置得到的牌数，不转动电机
+ * 按块展开计算每个座位和底牌位置的总牌数，与脚本声明的牌数比较
+ * @param script 脚本
+ * @param players 菜单设置的玩家数
+ * @param seat_cards 输出：各座位的牌数
+ * @param base_cards 输出：底牌位置的牌数
+ * @return DealScriptErr_e 校验结果
+ */
+DealScriptErr_e DealScriptCheck(const DealScript_t *script, uint8_t players, uint16_t seat_cards[SEAT_MAX], uint16_t *base_cards)
+{
+    uint32_t mult[DS_DEPTH_MAX + 1] = {1};
+    uint8_t depth = 0, each = 0; // each: FOR_EACH_SEAT 所在的层，0 表示不在块内
+    uint8_t pos = DS_POS_NONE;
+    uint8_t i, s, op, arg;
+
+    players = DealScriptPlayers(script, players);
+    for (s = 0; s < SEAT_MAX; s++)
+    {
+        seat_cards[s] = 0;
+    }
+    *base_cards = 0;
+    if (players == 0)
+    {
+        return DS_ERR_SEAT;
+    }
+
+    for (i = 0; i + 1U < script->size; i += 2)
+    {
+        op = script->code[i];
+        arg = script->code[i + 1];
+        switch (op)
+        {
+        case DS_OP_END:
+            if (depth != 0)
+            {
+                return DS_ERR_BLOCK;
+            }
+            for (s = 0; s < players; s++)
+            {
+                if (seat_cards[s] != script->cards)
+                {
+                    return DS_ERR_COUNT;
+                }
+            }
+            return (*base_cards == script->base) ? DS_OK : DS_ERR_COUNT;
+
+        case DS_OP_ROTATE_TO:
+            if (each != 0)
+            {
+                return DS_ERR_NEST;
+            }
+            if (arg != DS_SEAT_BASE && arg >= players)
+            {
+                return DS_ERR_SEAT;
+            }
+            pos = arg;
+            break;
+
+        case DS_OP_EJECT:
+            if (each != 0)
+            {
+                for (s = 0; s < players; s++)
+                {
+                    DealScriptAdd(&seat_cards[s], arg * mult[depth]);
+                }
+            }
+            else if (pos == DS_SEAT_BASE)
+            {
+                DealScriptAdd(base_cards, arg * mult[depth]);
+            }
+            else if (pos < players)
+            {
+                DealScriptAdd(&seat_cards[pos], arg * mult[depth]);
+            }
+            else
+            {
+                return DS_ERR_SEAT;
+            }
+            break;
+
+        case DS_OP_BASE_PILE:
+            if (each != 0)
+            {
+                return DS_ERR_NEST;
+            }
+            pos = DS_SEAT_BASE;
+            DealScriptAdd(base_cards, arg * mult[depth]);
+            break;
+
+        case DS_OP_REPEAT:
+        case DS_OP_FOR_EACH_SEAT:
+            if (depth >= DS_DEPTH_MAX)
+            {
+                return DS_ERR_BLOCK;
+            }
+            if (op == DS_OP_FOR_EACH_SEAT)
+            {
+                if (each != 0)
+                {
+                    return DS_ERR_NEST;
+                }
+                each = depth + 1;
+                mult[depth + 1] = mult[depth];
+            }
+            else
+            {
+                mult[depth + 1] = mult[depth] * arg;
+            }
+            depth++;
+            break;
+
+        case DS_OP_NEXT:
+            if (depth == 0)
+            {
+                return DS_ERR_BLOCK;
+            }
+            if (each == depth)
+            {
+                each = 0;
+                pos = DS_POS_NONE; // 最后一个座位取决于开始时的航向
+            }
+            depth--;
+            break;
+
+        default:
+            return DS_ERR_OP;
+        }
+    }
+    return DS_ERR_OP;
+}
@@ -11,14 +11,19 @@ void FlashInit(void)
 
 /**
  * @brief 写入Flash
- * @param address: 起始地址
+ * 擦除地址所在的整页后按双字编程，每两个字组成一个双字，奇数长度末尾补0xFFFFFFFF
+ * @param address: 起始地址，需8字节对齐
  * @param data: 数据起始地址
- * @param length: 数据长度
+ * @param length: 数据长度(字)
  * @return status: 写入结果
 */
 HAL_StatusTypeDef FlashWrite(uint32_t address, uint32_t *data, uint32_t length)
 {
     HAL_StatusTypeDef status = HAL_OK;
+    if (address & 0x7U)
+    {
+        return HAL_ERROR; // 双字编程要求8字节对齐
+    }
     // 解锁flash
     HAL_FLASH_Unlock();
     
@@ -27,17 +32,18 @@ HAL_StatusTypeDef FlashWrite(uint32_t address, uint32_t *data, uint32_t length)
     uint32_t PAGEError = 0;
     EraseInitStruct.TypeErase = FLASH_TYPEERASE_PAGES;
     EraseInitStruct.Banks = FLASH_BANK_1;             // 假设只操作第一个Bank
-    EraseInitStruct.Page = address / FLASH_PAGE_SIZE; // 计算起始页
+    EraseInitStruct.Page = (address - FLASH_BASE) / FLASH_PAGE_SIZE; // 计算起始页
     EraseInitStruct.NbPages = 1;                      // 假设每次只擦除1页
     status = HAL_FLASHEx_Erase(&EraseInitStruct, &PAGEError);
 
     if (status == HAL_OK)
     {
-        for (uint32_t i = 0; i < length; i++)
+        for (uint32_t i = 0; i < length; i += 2)
         {
-            if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + (i * 8), data[i]) != HAL_OK)
+            uint64_t dword = data[i] | ((uint64_t)((i + 1 < length) ? data[i + 1] : 0xFFFFFFFFU) << 32);
+
+            if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + (i * 4), dword) != HAL_OK)
             {
-                // mark: 由于FLASH_TYPEPROGRAM_DOUBLEWORD是64bit需要调整data[i]来适应他的数据类型
                 status = HAL_ERROR;
                 break;
             }
@@ -49,6 +55,27 @@ HAL_StatusTypeDef FlashWrite(uint32_t address, uint32_t *data, uint32_t length)
 }
 
 
+/**
+ * @brief 在已擦除的位置编程一个双字，不擦除页
+ * 用于页内追加记录，目标位置需为擦除状态(全0xFF)
+ * @param address: 目标地址，需8字节对齐
+ * @param dword: 数据
+ * @return status: 写入结果
+*/
+HAL_StatusTypeDef FlashProgramDword(uint32_t address, uint64_t dword)
+{
+    HAL_StatusTypeDef status;
+    if (address & 0x7U)
+    {
+        return HAL_ERROR;
+    }
+    HAL_FLASH_Unlock();
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address, dword);
+    HAL_FLASH_Lock();
+    return status;
+}
+
+
 
 
 /**
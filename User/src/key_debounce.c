@@ -0,0 +1,114 @@
+#include "key_debounce.h"
+
+/* 函数体 --------------------------------------------------------------------*/
+/**
+ * @brief 用一次采样更新消抖状态并判断按键事件
+ * 采样与消抖状态连续4次不同才翻转；单击/长按由按下时刻判断，状态变化和连发通过 sink 输出
+ * @param kd 消抖状态
+ * @param sample 按下位图
+ * @param now 采样时刻(tick)
+ * @param sink 事件输出
+ * @return uint8_t 本次产生的事件数
+ */
+uint8_t KeyDebounceUpdate(KeyDebounce_t *kd, uint8_t sample, uint32_t now, KeyEventSink_t sink)
+{
+    uint8_t delta = sample ^ kd->down;
+    uint8_t toggled = 0;
+    uint8_t pending = 0;
+    uint8_t bit = 0;
+    uint8_t events = 0;
+    key_t *key;
+
+    // 垂直计数器：不同的位递减计数，相同的位复位
+    kd->vc_cnt0 = ~(kd->vc_cnt0 & delta);
+    kd->vc_cnt1 = kd->vc_cnt0 ^ (kd->vc_cnt1 & delta);
+    toggled = delta & kd->vc_cnt0 & kd->vc_cnt1;
+    kd->down ^= toggled;
+
+    // 只处理有变化、仍按下或状态未回到空闲的按键
+    pending = toggled | kd->down | kd->busy;
+    for (uint8_t i = 0; pending != 0; i++, pending >>= 1)
+    {
+        if ((pending & 1) == 0)
+        {
+            continue;
+        }
+        bit = 1U << i;
+        key = &kd->keys[i];
+        key->last_state = key->state;
+
+        if (toggled & kd->down & bit)
+        {
+            key->state = KEY_PRESSED;
+            key->press_tick = now;
+            if (KEY_REPEAT_MASK & bit)
+            {
+                kd->repeat_key = i;
+                kd->repeat_interval = KEY_REPEAT_START;
+                kd->repeat_due = now + KEY_MS_TO_TICKS(KEY_REPEAT_DELAY);
+            }
+        }
+        else if (toggled & bit)
+        {
+            if (kd->repeat_key == i)
+            {
+                kd->repeat_key = KEY_NO_REPEAT;
+            }
+            if (key->state == KEY_PRESSED && (now - key->press_tick) < KEY_MS_TO_TICKS(KEY_CLICK_THRESHOLD))
+            {
+                key->state = KEY_CLICKED;
+            }
+            else
+            {
+                key->state = KEY_RELEASED;
+            }
+        }
+        else if (kd->down & bit)
+        {
+            if (key->state == KEY_PRESSED && (now - key->press_tick) > KEY_MS_TO_TICKS(KEY_LONG_PRESS_THRESHOLD))
+            {
+                key->state = KEY_LONG_PRESSED;
+            }
+            else if (key->state == KEY_LONG_PRESSED)
+            {
+                key->state = KEY_LONG_PRESSED_BACK; // 长按事件只保持一个扫描周期
+            }
+
+            if (kd->repeat_key == i && (int32_t)(now - kd->repeat_due) >= 0)
+            {
+                if ((now - key->press_tick) >= KEY_MS_TO_TICKS(KEY_REPEAT_DECADE))
+                {
+                    sink(i, KEY_REPEAT, now, 10);
+                    kd->repeat_interval = KEY_REPEAT_DECADE_INTERVAL;
+                }
+                else
+                {
+                    sink(i, KEY_REPEAT, now, 1);
+                    kd->repeat_interval = (kd->repeat_interval > KEY_REPEAT_MIN + KEY_REPEAT_ACCEL) ? kd->repeat_interval - KEY_REPEAT_ACCEL : KEY_REPEAT_MIN;
+                }
+                kd->repeat_due = now + KEY_MS_TO_TICKS(kd->repeat_interval);
+                events++;
+            }
+        }
+        else
+        {
+            key->state = KEY_IDLE;
+        }
+
+        if (key->state != key->last_state && key->state != KEY_IDLE && key->state != KEY_LONG_PRESSED_BACK)
+        {
+            sink(i, key->state, now, 1);
+            events++;
+        }
+
+        if (key->state == KEY_IDLE)
+        {
+            kd->busy &= ~bit;
+        }
+        else
+        {
+            kd->busy |= bit;
+        }
+    }
+    return events;
+}
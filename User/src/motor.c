@@ -1,41 +1,1007 @@
 #include "motor.h"
 #include "gpio.h"
+#include "flash_operation.h"
+#include <stddef.h>
+#include <string.h>
 
 
+// CCMR2 输出比较模式：通道3在低字节，通道4在高字节，一次写入同时切换两路
+#define OC3_PWM         (TIM_CCMR2_OC3M_2 | TIM_CCMR2_OC3M_1 | TIM_CCMR2_OC3PE)
+#define OC3_FORCE_HIGH  (TIM_CCMR2_OC3M_2 | TIM_CCMR2_OC3M_0)
+#define OC3_FORCE_LOW   (TIM_CCMR2_OC3M_2)
+#define OC4_PWM         (TIM_CCMR2_OC4M_2 | TIM_CCMR2_OC4M_1 | TIM_CCMR2_OC4PE)
+#define OC4_FORCE_HIGH  (TIM_CCMR2_OC4M_2 | TIM_CCMR2_OC4M_0)
+#define OC4_FORCE_LOW   (TIM_CCMR2_OC4M_2)
 
+#define BRAKE_HOLD      0xFFFFU     // 持续制动，直到下次启动
 
+static void LegPwmSetDuty(Motor_t *motor, uint32_t ccr);
+static void LegPwmDirection(Motor_t *motor, MotorDirection_e direction);
+static void LegPwmBrake(Motor_t *motor);
+static void LegPwmCoast(Motor_t *motor);
+static void EnPwmSetDuty(Motor_t *motor, uint32_t ccr);
+static void EnPwmDirection(Motor_t *motor, MotorDirection_e direction);
+static void EnPwmBrake(Motor_t *motor);
+static void EnPwmCoast(Motor_t *motor);
+
+// 方向脚PWM：FI/BI为定时器通道，按方向只在一路上输出PWM，使能为GPIO
+static const MotorOps_t leg_pwm_ops = {LegPwmSetDuty, LegPwmDirection, LegPwmBrake, LegPwmCoast};
+// 使能脚PWM：使能为定时器通道，FI/BI为方向GPIO
+static const MotorOps_t en_pwm_ops = {EnPwmSetDuty, EnPwmDirection, EnPwmBrake, EnPwmCoast};
+
+// 出牌电机：Fi(PB0)/Bi(PB1) 为 TIM3_CH3/CH4，使能(PA2)无定时器通道
+static const MotorHw_t out_hw = {
+    .tim = TIM3,
+    .ccr_fi = &TIM3->CCR3,
+    .ccr_bi = &TIM3->CCR4,
+    .ccr_en = NULL,
+    .ccmr_run = OC3_PWM | OC4_PWM,
+    .ccmr_high = OC3_FORCE_HIGH | OC4_FORCE_HIGH,
+    .ccmr_low = OC3_FORCE_LOW | OC4_FORCE_LOW,
+    .fi_port = outMotorFi_GPIO_Port,
+    .fi_pin = outMotorFi_Pin,
+    .bi_pin = outMotorBi_Pin,
+    .en_port = outSdb628Enable_GPIO_Port,
+    .en_pin = outSdb628Enable_Pin,
+};
+
+// 旋转电机：使能(PB6) 为 TIM1_CH3，Fi(PB9)/Bi(PB8) 为方向GPIO
+static const MotorHw_t rotate_hw = {
+    .tim = TIM1,
+    .ccr_fi = NULL,
+    .ccr_bi = NULL,
+    .ccr_en = &TIM1->CCR3,
+    .ccmr_run = OC3_PWM,
+    .ccmr_high = OC3_FORCE_HIGH,
+    .ccmr_low = OC3_FORCE_LOW,
+    .fi_port = rotateMotorFi_GPIO_Port,
+    .fi_pin = rotateMotorFi_Pin,
+    .bi_pin = rotateMotorBi_Pin,
+    .en_port = rotateSdb628Enable_GPIO_Port,
+    .en_pin = rotateSdb628Enable_Pin,
+};
+
+// 电机
+Motor_t motor[2] = {
+    {.id = OUTMOTOR,
+     .current_pos = 0,
+     .cards = 0,
+     .totalCards = 0,
+     .direction = MOTOR_STOP,
+     .hw = &out_hw,
+     .ops = &leg_pwm_ops,
+     .profile = {MOTOR_OUT_MAX_DUTY, MOTOR_OUT_MIN_DUTY, MOTOR_OUT_ACCEL_MS, MOTOR_OUT_DECEL_MS, MOTOR_RAMP_TRAPEZOID, MOTOR_OUT_BRAKE_MS}},
+    {.id = ROTATEMOTOR,
+     .current_pos = 0,
+     .cards = 0,
+     .totalCards = 0,
+     .direction = MOTOR_STOP,
+     .hw = &rotate_hw,
+     .ops = &en_pwm_ops,
+     .profile = {MOTOR_ROTATE_MAX_DUTY, MOTOR_ROTATE_MIN_DUTY, MOTOR_ROTATE_ACCEL_MS, MOTOR_ROTATE_DECEL_MS, MOTOR_RAMP_S_CURVE, MOTOR_ROTATE_BRAKE_MS}}};
+
+// 持久化参数，整体写入 MOTOR_PARAM_ADDR；航向变化频繁，单独追加到 MOTOR_HEADING_LOG_ADDR 之后
+typedef struct{
+    uint32_t magic;
+    uint32_t decel[2];              // 学习到的制动减速度(Q8)
+    uint32_t seat_count;            // 座位表标定时的玩家数，0 表示未标定
+    uint8_t seat[SEAT_MAX];         // 各座位所在扇区
+    uint32_t check;                 // 校验：各字异或取反
+} MotorParam_t;
+
+static MotorParam_t motor_param = {MOTOR_PARAM_MAGIC, {MOTOR_DECEL_DEFAULT, MOTOR_DECEL_DEFAULT}, 0, {0}, 0};
+static uint32_t param_saved[2] = {MOTOR_DECEL_DEFAULT, MOTOR_DECEL_DEFAULT};
+static bool param_dirty = false;
+static bool param_fault = false;    // 写flash失败后不再重试，直到复位
+static uint32_t heading_saved = 0;  // 最后一条航向记录
+static uint32_t heading_next = MOTOR_HEADING_LOG_ADDR; // 下一条航向记录的地址
+
+static uint32_t pwm_period = 1;     // 定时器计数周期 ARR + 1
+
+// 紧急切断锁存：触摸中断中置位，置位期间不允许重新打开H桥使能
+static volatile bool motor_cut = false;
+
+static void MotorBridge(Motor_t *motor, MotorBridge_e bridge);
+static void MotorParamLoad(void);
+
+/**
+ * @brief 初始化电机PWM
+ * 出牌电机：Fi(PB0)/Bi(PB1) 为 TIM3_CH3/CH4，按方向只在一路上输出PWM，使能(PA2)无定时器通道，仍为GPIO
+ * 旋转电机：使能(PB6) 为 TIM1_CH3 输出PWM，Fi(PB9)/Bi(PB8) 为方向GPIO
+ * @retval None
+*/
+void MotorInit(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    __HAL_RCC_TIM1_CLK_ENABLE();
+    __HAL_RCC_TIM3_CLK_ENABLE();
+
+    pwm_period = SystemCoreClock / MOTOR_PWM_HZ;
+
+    TIM3->CR1 = 0;
+    TIM3->PSC = 0;
+    TIM3->ARR = pwm_period - 1;
+    TIM3->CCR3 = 0;
+    TIM3->CCR4 = 0;
+    TIM3->CCMR2 = OC3_FORCE_LOW | OC4_FORCE_LOW;   // 输出模式由MotorBridge切换
+    TIM3->CCER = TIM_CCER_CC3E | TIM_CCER_CC4E;
+    TIM3->EGR = TIM_EGR_UG;
+    TIM3->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
+
+    TIM1->CR1 = 0;
+    TIM1->PSC = 0;
+    TIM1->ARR = pwm_period - 1;
+    TIM1->CCR3 = 0;
+    TIM1->CCMR2 = OC3_FORCE_LOW;
+    TIM1->CCER = TIM_CCER_CC3E;
+    TIM1->CR2 = 0;                          // OIS3 = 0：MOE清零后输出低电平
+    TIM1->BDTR = TIM_BDTR_OSSI | TIM_BDTR_MOE;
+    TIM1->EGR = TIM_EGR_UG;
+    TIM1->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
+
+    // 强制低电平，切换到复用功能时引脚保持低电平
+    GPIO_InitStruct.Pin = outMotorFi_Pin | outMotorBi_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF1_TIM3;
+    HAL_GPIO_Init(outMotorFi_GPIO_Port, &GPIO_InitStruct);
+
+    GPIO_InitStruct.Pin = rotateSdb628Enable_Pin;
+    GPIO_InitStruct.Alternate = GPIO_AF1_TIM1;
+    HAL_GPIO_Init(rotateSdb628Enable_GPIO_Port, &GPIO_InitStruct);
+
+    if (motor_cut)
+    {
+        TIM1->BDTR &= ~TIM_BDTR_MOE;
+    }
+    MotorBridge(&motor[OUTMOTOR], BRIDGE_COAST);
+    MotorBridge(&motor[ROTATEMOTOR], BRIDGE_COAST);
+    MotorParamLoad();
+}
+
+/**
+ * @brief 计算参数校验值
+ * @param param 参数
+ * @return uint32_t 校验值
+*/
+static uint32_t MotorParamCheck(const MotorParam_t *param)
+{
+    const uint32_t *word = (const uint32_t *)param;
+    uint32_t check = 0;
+
+    for (uint8_t i = 0; i < offsetof(MotorParam_t, check) / sizeof(uint32_t); i++)
+    {
+        check ^= word[i];
+    }
+    return ~check;
+}
+
+/**
+ * @brief 扫描航向记录区，取最后一条有效记录并定位下一个空位
+ * 每条记录低字为航向，高字为其取反；掉电写坏的记录跳过但占用位置
+ * @return uint32_t 最后一条有效航向，没有时为0
+*/
+static uint32_t MotorHeadingLoad(void)
+{
+    uint32_t entry[2];
+    uint32_t heading = 0;
+    uint32_t addr;
+
+    for (addr = MOTOR_HEADING_LOG_ADDR; addr < MOTOR_HEADING_LOG_END; addr += 8U)
+    {
+        FlashRead(addr, entry, 2);
+        if (entry[0] == 0xFFFFFFFFU && entry[1] == 0xFFFFFFFFU)
+        {
+            break;
+        }
+        if (entry[1] == ~entry[0])
+        {
+            heading = entry[0];
+        }
+    }
+    heading_next = addr;
+    return heading;
+}
+
+/**
+ * @brief 从flash读取学习参数和航向，无效时保持默认值
+ * @retval None
+*/
+static void MotorParamLoad(void)
+{
+    MotorParam_t param;
+    uint32_t heading;
+
+    FlashRead(MOTOR_PARAM_ADDR, (uint32_t *)&param, sizeof(param) / sizeof(uint32_t));
+    if (param.magic != MOTOR_PARAM_MAGIC || param.check != MotorParamCheck(&param) ||
+        param.decel[0] < MOTOR_DECEL_MIN || param.decel[1] < MOTOR_DECEL_MIN)
+    {
+        heading_next = MOTOR_HEADING_LOG_END; // 页内容无效，下次保存时擦页重写
+        return;
+    }
+    if (param.seat_count > SEAT_MAX)
+    {
+        param.seat_count = 0;
+    }
+    motor_param = param;
+    param_saved[0] = param.decel[0];
+    param_saved[1] = param.decel[1];
+
+    heading = MotorHeadingLoad();
+    heading_saved = heading;
+    if ((heading & MOTOR_HEADING_VALID) && (heading & 0xFFU) < ROTATE_SECTORS)
+    {
+        // 关机时保存的航向，转盘断电后被手动转动时，经过原点槽会被校正
+        motor[ROTATEMOTOR].current_pos = (int16_t)(heading & 0xFFU);
+        motor[ROTATEMOTOR].homed = true;
+    }
+}
+
+/**
+ * @brief 当前航向的保存格式
+ * @return uint32_t 未确定航向时为0
+*/
+static uint32_t MotorHeadingWord(void)
+{
+    return motor[ROTATEMOTOR].homed ? (MOTOR_HEADING_VALID | (uint32_t)motor[ROTATEMOTOR].current_pos) : 0;
+}
+
+/**
+ * @brief 在记录区追加一条航向
+ * @param heading 航向
+ * @return HAL_StatusTypeDef 写入结果
+*/
+static HAL_StatusTypeDef MotorHeadingAppend(uint32_t heading)
+{
+    HAL_StatusTypeDef status;
+
+    status = FlashProgramDword(heading_next, heading | ((uint64_t)~heading << 32));
+    heading_next += 8U;     // 失败的位置状态未知，不再使用
+    if (status == HAL_OK)
+    {
+        heading_saved = heading;
+    }
+    return status;
+}
+
+/**
+ * @brief 擦页重写学习参数，并把当前航向写为第一条记录
+ * @return HAL_StatusTypeDef 写入结果
+*/
+static HAL_StatusTypeDef MotorParamWrite(void)
+{
+    motor_param.check = MotorParamCheck(&motor_param);
+    if (FlashWrite(MOTOR_PARAM_ADDR, (uint32_t *)&motor_param, sizeof(motor_param) / sizeof(uint32_t)) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+    param_saved[0] = motor_param.decel[0];
+    param_saved[1] = motor_param.decel[1];
+    param_dirty = false;
+    heading_next = MOTOR_HEADING_LOG_ADDR;
+    return MotorHeadingAppend(MotorHeadingWord());
+}
+
+/**
+ * @brief 学习参数有变化时擦页重写flash
+ * 擦写期间CPU停顿，只在电机停止后(发牌结束)调用；写失败后不再重试
+ * @retval None
+*/
+void MotorParamSave(void)
+{
+    if (!param_dirty || param_fault)
+    {
+        return;
+    }
+    if (MotorParamWrite() != HAL_OK)
+    {
+        param_fault = true;
+    }
+}
+
+/**
+ * @brief 保存转盘航向和学习参数，都未变化时不写flash
+ * 航向只追加一个双字，记录区写满或学习参数变化时才擦页
+ * @retval None
+*/
+void MotorHeadingSave(void)
+{
+    uint32_t heading = MotorHeadingWord();
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if (param_fault)
+    {
+        return;
+    }
+    if (param_dirty || heading_next >= MOTOR_HEADING_LOG_END)
+    {
+        if (param_dirty || heading != heading_saved)
+        {
+            status = MotorParamWrite();
+        }
+    }
+    else if (heading != heading_saved)
+    {
+        status = MotorHeadingAppend(heading);
+    }
+    if (status != HAL_OK)
+    {
+        param_fault = true;
+    }
+}
+
+/**
+ * @brief 记录座位标定结果，随学习参数一起在发牌结束时写入flash
+ * @param sector 各座位所在扇区
+ * @param count 座位数(标定时的玩家数)
+ * @retval None
+*/
+void MotorSeatSet(const uint8_t *sector, uint8_t count)
+{
+    if (count > SEAT_MAX)
+    {
+        return;
+    }
+    memset(motor_param.seat, 0, sizeof(motor_param.seat));
+    memcpy(motor_param.seat, sector, count);
+    motor_param.seat_count = count;
+    param_dirty = true;
+}
+
+/**
+ * @brief 查询座位所在扇区
+ * @param count 当前玩家数，与标定时不同则视为未标定
+ * @param seat 座位 0 ~ count-1
+ * @return uint8_t 扇区号，未标定时为 SEAT_NONE
+*/
+uint8_t MotorSeatGet(uint8_t count, uint8_t seat)
+{
+    if (count == 0 || count != motor_param.seat_count || seat >= count)
+    {
+        return SEAT_NONE;
+    }
+    return motor_param.seat[seat];
+}
+
+/**
+ * @brief 设置电机加减速曲线，下一段斜坡起生效
+ * @param id 电机ID
+ * @param profile 曲线参数
+ * @retval None
+*/
+void MotorSetProfile(MotorId_e id, const MotorProfile_t *profile)
+{
+    MotorProfile_t p = *profile;
+
+    if (p.max_duty > MOTOR_DUTY_FULL)
+    {
+        p.max_duty = MOTOR_DUTY_FULL;
+    }
+    if (p.min_duty > p.max_duty)
+    {
+        p.min_duty = p.max_duty;
+    }
+    __disable_irq();
+    motor[id].profile = p;
+    __enable_irq();
+}
+
+/**
+ * @brief 获取电机加减速曲线
+ * @param id 电机ID
+ * @return const MotorProfile_t* 曲线参数
+*/
+const MotorProfile_t *MotorGetProfile(MotorId_e id)
+{
+    return &motor[id].profile;
+}
+
+/**
+ * @brief 获取电机当前输出占空比
+ * @param id 电机ID
+ * @return uint16_t 占空比(‰)
+*/
+uint16_t MotorGetDuty(MotorId_e id)
+{
+    return motor[id].state.duty;
+}
+
+/**
+ * @brief 方向脚PWM：按当前输出方向写FI/BI比较值，有输出时打开使能
+ * @param motor 电机结构体指针
+ * @param ccr 比较值
+ * @retval None
+*/
+static void LegPwmSetDuty(Motor_t *motor, uint32_t ccr)
+{
+    const MotorHw_t *hw = motor->hw;
+
+    *hw->ccr_fi = (motor->state.direction == MOTOR_FORWARD) ? ccr : 0;
+    *hw->ccr_bi = (motor->state.direction == MOTOR_REVERSE) ? ccr : 0;
+    hw->en_port->BSRR = ccr ? hw->en_pin : (uint32_t)hw->en_pin << 16;
+}
+
+/**
+ * @brief 方向脚PWM：进入PWM输出，方向由之后写入的比较值决定
+ * @param motor 电机结构体指针
+ * @param direction 方向
+ * @retval None
+*/
+static void LegPwmDirection(Motor_t *motor, MotorDirection_e direction)
+{
+    (void)direction;
+    motor->hw->tim->CCMR2 = motor->hw->ccmr_run;
+}
+
+/**
+ * @brief 方向脚PWM：FI/BI 一次CCMR2写入同时强制为高，再打开使能
+ * @param motor 电机结构体指针
+ * @retval None
+*/
+static void LegPwmBrake(Motor_t *motor)
+{
+    const MotorHw_t *hw = motor->hw;
+
+    hw->tim->CCMR2 = hw->ccmr_high;
+    if (!motor_cut)
+    {
+        hw->en_port->BSRR = hw->en_pin;
+    }
+}
+
+/**
+ * @brief 方向脚PWM：先关使能，再把FI/BI同时强制为低
+ * @param motor 电机结构体指针
+ * @retval None
+*/
+static void LegPwmCoast(Motor_t *motor)
+{
+    const MotorHw_t *hw = motor->hw;
+
+    hw->en_port->BSRR = (uint32_t)hw->en_pin << 16;
+    hw->tim->CCMR2 = hw->ccmr_low;
+}
+
+/**
+ * @brief 使能脚PWM：写使能比较值
+ * @param motor 电机结构体指针
+ * @param ccr 比较值
+ * @retval None
+*/
+static void EnPwmSetDuty(Motor_t *motor, uint32_t ccr)
+{
+    *motor->hw->ccr_en = ccr;
+}
+
+/**
+ * @brief 使能脚PWM：进入PWM输出，FI/BI 一次BSRR写入切换方向
+ * @param motor 电机结构体指针
+ * @param direction 方向
+ * @retval None
+*/
+static void EnPwmDirection(Motor_t *motor, MotorDirection_e direction)
+{
+    const MotorHw_t *hw = motor->hw;
+    uint32_t fi = hw->fi_pin, bi = hw->bi_pin;
+
+    hw->tim->CCMR2 = hw->ccmr_run;
+    if (direction == MOTOR_FORWARD)
+    {
+        hw->fi_port->BSRR = fi | (bi << 16);
+    }
+    else if (direction == MOTOR_REVERSE)
+    {
+        hw->fi_port->BSRR = bi | (fi << 16);
+    }
+    else
+    {
+        hw->fi_port->BSRR = (fi | bi) << 16;
+    }
+}
+
+/**
+ * @brief 使能脚PWM：先把FI/BI同时拉高，再强制使能为高(切断时MOE已清零，使能仍为低)
+ * @param motor 电机结构体指针
+ * @retval None
+*/
+static void EnPwmBrake(Motor_t *motor)
+{
+    const MotorHw_t *hw = motor->hw;
+
+    hw->fi_port->BSRR = hw->fi_pin | hw->bi_pin;
+    hw->tim->CCMR2 = hw->ccmr_high;
+}
+
+/**
+ * @brief 使能脚PWM：先强制使能为低，再同时复位FI/BI
+ * @param motor 电机结构体指针
+ * @retval None
+*/
+static void EnPwmCoast(Motor_t *motor)
+{
+    const MotorHw_t *hw = motor->hw;
+
+    hw->tim->CCMR2 = hw->ccmr_low;
+    hw->fi_port->BSRR = (uint32_t)(hw->fi_pin | hw->bi_pin) << 16;
+}
+
+/**
+ * @brief 把当前方向和占空比写到输出
+ * @param motor 电机结构体指针
+ * @retval None
+*/
+static void MotorOutput(Motor_t *motor)
+{
+    uint32_t ccr = motor_cut ? 0 : (uint32_t)motor->state.duty * pwm_period / MOTOR_DUTY_FULL;
+
+    if (motor->state.direction == MOTOR_STOP)
+    {
+        ccr = 0;
+    }
+    motor->ops->set_duty(motor, ccr);
+}
 
 /**
- * @brief 设置电机引脚状态
- * @param portF 电机正转引脚所在的GPIO端口
- * @param pinF 电机正转引脚编号
- * @param stateF 电机正转引脚状态
- * @param portB 电机反转引脚所在的GPIO端口
- * @param pinB 电机反转引脚编号
- * @param stateB 电机反转引脚状态
- * @param portS 电机使能引脚所在的GPIO端口
- * @param pinS 电机使能引脚编号
- * @param stateS 电机使能引脚状态
+ * @brief 切换桥臂状态
+ * FI/BI 每次切换只用一次寄存器写入，不会出现两路方向不一致的中间态
+ * @param motor 电机结构体指针
+ * @param bridge 目标状态
  * @retval None
 */
-static void SetMotorPins(GPIO_TypeDef *portF, uint16_t pinF, GPIO_PinState stateF,
-                         GPIO_TypeDef *portB, uint16_t pinB, GPIO_PinState stateB,
-                         GPIO_TypeDef *portS, uint16_t pinS, GPIO_PinState stateS)
+static void MotorBridge(Motor_t *motor, MotorBridge_e bridge)
 {
-    HAL_GPIO_WritePin(portF, pinF, stateF);
-    HAL_GPIO_WritePin(portB, pinB, stateB);
-    HAL_GPIO_WritePin(portS, pinS, stateS);
+    motor->bridge = bridge;
+    if (bridge != BRIDGE_BRAKE)
+    {
+        motor->brake_left = 0;
+    }
+    switch (bridge)
+    {
+    case BRIDGE_RUN:
+        motor->ops->direction(motor, motor->state.direction);
+        break;
+    case BRIDGE_BRAKE:
+        motor->ops->brake(motor);
+        break;
+    default:
+        motor->ops->coast(motor);
+        break;
+    }
 }
 
 /**
- * @brief 设置电机方向
+ * @brief 开始一段新的斜坡
+ * 从停止起步时直接跳到起动占空比，斜坡时间按占空比变化量占满量程的比例缩放
  * @param motor 电机结构体指针
- * @param direction 电机方向
+ * @param to 斜坡终点
  * @retval None
 */
-static void SetMotorDirection(Motor_t *motor, MotorDirection_e direction)
+static void MotorRampStart(Motor_t *motor, uint16_t to)
 {
+    const MotorProfile_t *profile = &motor->profile;
+    uint16_t from = motor->state.duty;
+    uint16_t span, ms;
+
+    if (from == 0 && to > 0)
+    {
+        from = (profile->min_duty < to) ? profile->min_duty : to;
+    }
+    span = (to > from) ? to - from : from - to;
+    ms = (to > from) ? profile->accel_ms : profile->decel_ms;
+
+    motor->ramp_from = from;
+    motor->ramp_to = to;
+    motor->ramp_t = 0;
+    motor->ramp_len = profile->max_duty ? (uint32_t)span * ms / profile->max_duty : 0;
+    motor->state.duty = from;
+}
+
+/**
+ * @brief 推进一路电机的斜坡
+ * @param motor 电机结构体指针
+ * @retval None
+*/
+static void MotorRampStep(Motor_t *motor)
+{
+    uint16_t from = motor->ramp_from, to = motor->ramp_to;
+    uint32_t x;
+
+    if (motor->state.duty == to)
+    {
+        return;
+    }
+    if (++motor->ramp_t >= motor->ramp_len)
+    {
+        motor->state.duty = to;
+        return;
+    }
+    x = ((uint32_t)motor->ramp_t << 10) / motor->ramp_len;   // 进度 Q10
+    if (motor->profile.curve == MOTOR_RAMP_S_CURVE)
+    {
+        x = (x * x * (3 * 1024 - 2 * x)) >> 20;               // smoothstep 3x²-2x³
+    }
+    if (to > from)
+    {
+        motor->state.duty = from + (uint16_t)(((uint32_t)(to - from) * x) >> 10);
+    }
+    else
+    {
+        motor->state.duty = from - (uint16_t)(((uint32_t)(from - to) * x) >> 10);
+    }
+}
+
+/**
+ * @brief 推进一路电机：换向、制动计时、斜坡和输出
+ * 换向时先减速到0，停稳后再切换方向并重新加速
+ * @param motor 电机结构体指针
+ * @retval None
+*/
+static void MotorTick(Motor_t *motor)
+{
+    MotorState_t *state = &motor->state;
+    uint16_t goal;
+
+    if (motor_cut)
+    {
+        state->duty = 0;
+        motor->ramp_to = 0;
+    }
+    if (motor->req_dir != state->direction && state->duty == 0)
+    {
+        state->direction = motor->req_dir;
+        if (state->direction != MOTOR_STOP)
+        {
+            state->travel = state->direction;
+            MotorBridge(motor, BRIDGE_RUN);
+        }
+        else if (motor->bridge == BRIDGE_RUN)
+        {
+            MotorBridge(motor, BRIDGE_COAST);   // 斜坡停止结束后惰行
+        }
+    }
+    if (motor->bridge != BRIDGE_RUN)
+    {
+        if (motor->brake_left != 0 && motor->brake_left != BRAKE_HOLD && --motor->brake_left == 0)
+        {
+            MotorBridge(motor, BRIDGE_COAST);
+        }
+        return;
+    }
+    goal = (motor->req_dir == state->direction && !motor_cut) ? motor->target : 0;
+    if (goal != motor->ramp_to)
+    {
+        MotorRampStart(motor, goal);
+    }
+    MotorRampStep(motor);
+    MotorOutput(motor);
+    if (state->duty > 0)
+    {
+        state->runtime++;
+    }
+}
+
+/**
+ * @brief 电机斜坡节拍，1ms调用一次
+ * @retval None
+*/
+void MotorRampTick(void)
+{
+    for (uint8_t id = OUTMOTOR; id <= ROTATEMOTOR; id++)
+    {
+        __disable_irq();
+        MotorTick(&motor[id]);
+        __enable_irq();
+    }
+}
+
+/**
+ * @brief 设置电机目标方向和占空比，由斜坡节拍平滑过渡
+ * 重复设置相同的目标不会重新开始斜坡
+ * @param motor 电机结构体指针
+ * @param direction 目标方向
+ * @param duty 目标占空比(‰)
+ * @retval None
+*/
+void MotorSetSpeed(Motor_t *motor, MotorDirection_e direction, uint16_t duty)
+{
+    if (duty > MOTOR_DUTY_FULL)
+    {
+        duty = MOTOR_DUTY_FULL;
+    }
+    if (direction == MOTOR_STOP || duty == 0)
+    {
+        direction = MOTOR_STOP;
+        duty = 0;
+    }
     motor->direction = direction;
+    __disable_irq();
+    motor->req_dir = direction;
+    motor->target = duty;
+    __enable_irq();
+}
+
+/**
+ * @brief 按减速曲线平滑停止
+ * @param motor 电机结构体指针
+ * @retval None
+*/
+void MotorRampStop(Motor_t *motor)
+{
+    MotorSetSpeed(motor, MOTOR_STOP, 0);
+}
+
+/**
+ * @brief 按指定方式立即停止，不经过减速斜坡
+ * @param motor 电机结构体指针
+ * @param mode 停止方式
+ * @retval None
+*/
+void MotorStop(Motor_t *motor, MotorStopMode_e mode)
+{
+    motor->direction = MOTOR_STOP;
+    __disable_irq();
+    if (mode == MOTOR_STOP_BRAKE_COAST && motor->state.direction == MOTOR_STOP &&
+        motor->req_dir == MOTOR_STOP && motor->bridge != BRIDGE_RUN)
+    {
+        __enable_irq();
+        return; // 已经停稳，重复调用不重新开始制动计时
+    }
+    motor->state.direction = MOTOR_STOP;
+    motor->state.duty = 0;
+    motor->req_dir = MOTOR_STOP;
+    motor->target = 0;
+    motor->ramp_to = 0;
+    MotorOutput(motor);
+    if (mode == MOTOR_STOP_COAST || (mode == MOTOR_STOP_BRAKE_COAST && motor->profile.brake_ms == 0))
+    {
+        MotorBridge(motor, BRIDGE_COAST);
+    }
+    else
+    {
+        MotorBridge(motor, BRIDGE_BRAKE);
+        motor->brake_left = (mode == MOTOR_STOP_BRAKE) ? BRAKE_HOLD : motor->profile.brake_ms;
+    }
+    __enable_irq();
+}
+
+/**
+ * @brief 旋转里程：按方向更新扇区号，遮挡比例明显大于普通槽时判为原点槽
+ * 正转越过原点槽进入0号扇区，反转越过则进入最后一个扇区
+ * @param motor 电机结构体指针
+ * @param period 与上一个边沿的间隔(us)，0 表示未知
+ * @param width 本次遮挡时长(us)
+ * @retval None
+*/
+static void RotateOdometry(Motor_t *motor, uint32_t period, uint32_t width)
+{
+    MotorDirection_e travel = motor->state.travel;
+    uint32_t ratio;
+
+    motor->current_pos = (int16_t)((motor->current_pos + travel + ROTATE_SECTORS) % ROTATE_SECTORS);
+    if (period == 0 || travel == MOTOR_STOP)
+    {
+        return;
+    }
+    ratio = (width >= period) ? 0xFFFFU : (width << 8) / period;
+    if (motor->slot_ratio != 0 && (ratio << 8) > (uint32_t)motor->slot_ratio * ROTATE_HOME_RATIO)
+    {
+        motor->current_pos = (travel == MOTOR_FORWARD) ? 0 : (int16_t)(ROTATE_SECTORS - 1);
+        motor->homed = true;
+    }
+    else
+    {
+        motor->slot_ratio = motor->slot_ratio ? (uint16_t)(motor->slot_ratio - motor->slot_ratio / 8 + ratio / 8) : (uint16_t)ratio;
+    }
+}
+
+/**
+ * @brief 记录一次光耦边沿，可在中断中调用
+ * 旋转电机更新扇区号，出牌电机每个边沿计一张牌；同时用相邻边沿间隔估计速度
+ * @param motor 电机结构体指针
+ * @param us 边沿时刻(us)
+ * @param width 本次遮挡时长(us)
+ * @retval None
+*/
+void MotorEdge(Motor_t *motor, uint32_t us, uint32_t width)
+{
+    MotorState_t *state = &motor->state;
+    MotorPredict_t *p = &motor->predict;
+    uint32_t period = 0;
+
+    if (p->edges > 0)
+    {
+        period = us - state->edge_us;
+        p->period = (period < MOTOR_PERIOD_MIN_US) ? MOTOR_PERIOD_MIN_US : period;
+    }
+    if (p->edges < 0xFF)
+    {
+        p->edges++;
+    }
+    state->edges++;
+    state->edge_us = us;
+    if (motor->id == ROTATEMOTOR)
+    {
+        RotateOdometry(motor, period, width);
+    }
+    else
+    {
+        motor->cards++;
+        motor->totalCards++;
+    }
+}
+
+/**
+ * @brief 开始一次定位运动，清除上次的边沿计时
+ * @param id 电机ID
+ * @retval None
+*/
+void MotorPredictStart(MotorId_e id)
+{
+    motor[id].predict.edges = 0;
+    motor[id].predict.period = 0;
+}
+
+/**
+ * @brief 按速度估算制动距离 v²/(2a)
+ * @param id 电机ID
+ * @param speed 速度(MOTOR_PITCH/ms)
+ * @return uint32_t 制动距离
+*/
+static uint32_t MotorStopDistance(MotorId_e id, uint32_t speed)
+{
+    return (uint32_t)(((uint64_t)speed * speed << 7) / motor_param.decel[id]);
+}
+
+/**
+ * @brief 判断是否该断电：剩余距离不大于制动距离(再留一个1ms轮询周期的余量)
+ * 返回 true 时记下断电时的速度和剩余距离，供之后学习
+ * @param id 电机ID
+ * @param now_us 当前时刻(us)
+ * @return true 现在断电可以停在下一个边沿
+*/
+bool MotorPredictStopDue(MotorId_e id, uint32_t now_us)
+{
+    MotorPredict_t *p = &motor[id].predict;
+    uint32_t speed, elapsed, travelled, remain;
+
+    if (p->period == 0)
+    {
+        return false; // 还没测到速度，只能到边沿再停
+    }
+    speed = MOTOR_PITCH * 1000U / p->period;
+    elapsed = now_us - motor[id].state.edge_us;
+    if (elapsed > p->period)
+    {
+        elapsed = p->period; // 变慢了，剩余距离按0算
+    }
+    travelled = (uint32_t)((uint64_t)elapsed * speed / 1000U);
+    remain = (travelled < MOTOR_PITCH) ? MOTOR_PITCH - travelled : 0;
+    if (remain > MotorStopDistance(id, speed) + speed)
+    {
+        return false;
+    }
+    p->cut_us = now_us;
+    p->cut_speed = speed;
+    p->cut_remain = remain;
+    return true;
+}
+
+/**
+ * @brief 断电后等待越过目标边沿的时间，取匀减速停止时间的两倍
+ * @param id 电机ID
+ * @return uint16_t 等待时间(ms)
+*/
+uint16_t MotorPredictSettleMs(MotorId_e id)
+{
+    uint32_t ms = (motor[id].predict.cut_speed << 9) / motor_param.decel[id] + 20;
+
+    return (ms > MOTOR_SETTLE_MAX_MS) ? MOTOR_SETTLE_MAX_MS : (uint16_t)ms;
+}
+
+/**
+ * @brief 根据断电后的结果修正减速度
+ * 越过边沿：按匀减速模型 r = v·t - a·t²/2 由越过时刻反推 a，且 a 不超过恰好停在边沿所需的 v²/(2r)
+ * 未越过(停在座位前)：实际减速度大于 v²/(2r)，往大修正
+ * @param id 电机ID
+ * @param now_us 越过边沿的时刻，或放弃等待的时刻(us)
+ * @param crossed 是否越过了目标边沿
+ * @retval None
+*/
+void MotorPredictLearn(MotorId_e id, uint32_t now_us, bool crossed)
+{
+    const MotorPredict_t *p = &motor[id].predict;
+    uint32_t v = p->cut_speed, r = p->cut_remain;
+    uint32_t t = (now_us - p->cut_us) / 1000U;
+    uint32_t bound, meas, decel, saved;
+
+    if (v == 0 || r == 0)
+    {
+        return; // 断电时已在边沿上，无法区分
+    }
+    bound = (uint32_t)(((uint64_t)v * v << 7) / r);
+    if (crossed)
+    {
+        if (t == 0)
+        {
+            t = 1;
+        }
+        meas = (v * t > r) ? (uint32_t)(((uint64_t)(v * t - r) << 9) / ((uint64_t)t * t)) : MOTOR_DECEL_MIN;
+        if (meas > bound)
+        {
+            meas = bound;
+        }
+    }
+    else
+    {
+        meas = bound + bound / 4;
+    }
+    if (meas < MOTOR_DECEL_MIN)
+    {
+        meas = MOTOR_DECEL_MIN;
+    }
+    decel = motor_param.decel[id];
+    decel = decel - decel / 4 + meas / 4; // 一阶滤波，单次偶然值不会大幅改变
+    if (decel < MOTOR_DECEL_MIN)
+    {
+        decel = MOTOR_DECEL_MIN;
+    }
+    motor_param.decel[id] = decel;
+
+    saved = param_saved[id];
+    if ((decel > saved ? decel - saved : saved - decel) > saved / 8)
+    {
+        param_dirty = true; // 偏离已保存值超过1/8才写flash，减少擦写次数
+    }
+}
+
+/**
+ * @brief 紧急切断两路H桥使能，可在中断中调用
+ * 使能为GPIO的直接拉低，使能为定时器通道(TIM1)的清MOE让输出回到空闲低电平；方向引脚由之后的电机停止函数复位
+ * @retval None
+*/
+void MotorEmergencyCut(void)
+{
+    motor_cut = true;
+    for (uint8_t id = OUTMOTOR; id <= ROTATEMOTOR; id++)
+    {
+        const MotorHw_t *hw = motor[id].hw;
+
+        if (hw->ccr_en == NULL)
+        {
+            hw->en_port->BSRR = (uint32_t)hw->en_pin << 16;
+        }
+        else
+        {
+            hw->tim->BDTR &= ~TIM_BDTR_MOE;
+        }
+    }
+}
+
+/**
+ * @brief 解除紧急切断，允许电机重新启动
+ * @retval None
+*/
+void MotorCutRelease(void)
+{
+    motor_cut = false;
+    for (uint8_t id = OUTMOTOR; id <= ROTATEMOTOR; id++)
+    {
+        if (motor[id].hw->ccr_en != NULL)
+        {
+            motor[id].hw->tim->BDTR |= TIM_BDTR_MOE;
+        }
+    }
+}
+
+/**
+ * @brief 是否处于紧急切断状态
+ * @retval true 已切断
+*/
+bool MotorIsCut(void)
+{
+    return motor_cut;
 }
 
 /**
@@ -47,10 +1013,7 @@ void outMotorForward(Motor_t *motor)
 {
     if (motor->id == OUTMOTOR)
     {
-        SetMotorDirection(motor, MOTOR_FORWARD);
-        SetMotorPins(outMotorFi_GPIO_Port, outMotorFi_Pin, GPIO_PIN_SET,
-                     outMotorBi_GPIO_Port, outMotorBi_Pin, GPIO_PIN_RESET,
-                     outSdb628Enable_GPIO_Port, outSdb628Enable_Pin, GPIO_PIN_SET);
+        MotorSetSpeed(motor, MOTOR_FORWARD, motor->profile.max_duty);
     }
 }
 
@@ -63,24 +1026,18 @@ void outMotorBackward(Motor_t *motor)
 {
     if (motor->id == OUTMOTOR)
     {
-        SetMotorDirection(motor, MOTOR_REVERSE);
-        SetMotorPins(outMotorFi_GPIO_Port, outMotorFi_Pin, GPIO_PIN_RESET,
-                     outMotorBi_GPIO_Port, outMotorBi_Pin, GPIO_PIN_SET,
-                     outSdb628Enable_GPIO_Port, outSdb628Enable_Pin, GPIO_PIN_SET);
+        MotorSetSpeed(motor, MOTOR_REVERSE, motor->profile.max_duty);
     }
 }
 
 /**
- * @brief 出牌电机停止
+ * @brief 出牌电机停止，短暂制动后惰行
  * @param motor 电机结构体指针
  * @retval None
 */
 void outMotorStop(Motor_t *motor)
 {
-    SetMotorDirection(motor, MOTOR_STOP);
-    SetMotorPins(outMotorFi_GPIO_Port, outMotorFi_Pin, GPIO_PIN_RESET,
-                 outMotorBi_GPIO_Port, outMotorBi_Pin, GPIO_PIN_RESET,
-                 outSdb628Enable_GPIO_Port, outSdb628Enable_Pin, GPIO_PIN_RESET);
+    MotorStop(motor, MOTOR_STOP_BRAKE_COAST);
 }
 
 /**
@@ -89,13 +1046,10 @@ void outMotorStop(Motor_t *motor)
  * @retval None
 */
 void rotateMotorForward(Motor_t *motor)
-{   
+{
     if (motor->id == ROTATEMOTOR)
     {
-        SetMotorDirection(motor, MOTOR_FORWARD);
-        SetMotorPins(rotateMotorFi_GPIO_Port, rotateMotorFi_Pin, GPIO_PIN_SET,
-                     rotateMotorBi_GPIO_Port, rotateMotorBi_Pin, GPIO_PIN_RESET,
-                     rotateSdb628Enable_GPIO_Port, rotateSdb628Enable_Pin, GPIO_PIN_SET);
+        MotorSetSpeed(motor, MOTOR_FORWARD, motor->profile.max_duty);
     }
 }
 
@@ -108,24 +1062,18 @@ void rotateMotorBackward(Motor_t *motor)
 {
     if (motor->id == ROTATEMOTOR)
     {
-        SetMotorDirection(motor, MOTOR_REVERSE);
-        SetMotorPins(rotateMotorFi_GPIO_Port, rotateMotorFi_Pin, GPIO_PIN_RESET,
-                     rotateMotorBi_GPIO_Port, rotateMotorBi_Pin, GPIO_PIN_SET,
-                     rotateSdb628Enable_GPIO_Port, rotateSdb628Enable_Pin, GPIO_PIN_SET);
+        MotorSetSpeed(motor, MOTOR_REVERSE, motor->profile.max_duty);
     }
 }
 
 /**
- * @brief 旋转电机停止
+ * @brief 旋转电机停止，制动 brake_ms 后惰行，缩短越过光耦后的滑行距离
  * @param motor 电机结构体指针
  * @retval None
 */
 void rotateMotorStop(Motor_t *motor)
 {
-    SetMotorDirection(motor, MOTOR_STOP);   
-    SetMotorPins(rotateMotorFi_GPIO_Port, rotateMotorFi_Pin, GPIO_PIN_RESET,
-                 rotateMotorBi_GPIO_Port, rotateMotorBi_Pin, GPIO_PIN_RESET,
-                 rotateSdb628Enable_GPIO_Port, rotateSdb628Enable_Pin, GPIO_PIN_RESET);
+    MotorStop(motor, MOTOR_STOP_BRAKE_COAST);
 }
 
 
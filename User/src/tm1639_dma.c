@@ -0,0 +1,158 @@
+#include "tm1639_dma.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "log.h"
+
+// TM1639总线引脚(均在GPIOA)
+static const TM1639WavePins_t wave_pins = {tm1639Clk_Pin, tm1639Din_Pin, tm1639Stb_Pin};
+
+DMA_HandleTypeDef hdma_tim16_up;
+
+static uint32_t bsrr_buf[TM1639_DMA_BUF_WORDS];
+static volatile uint8_t dma_busy = 0;
+static volatile uint8_t dma_given = 0;  // 传输完成中断给出的通知数
+static TaskHandle_t waiting_task = NULL;
+
+static void TM1639DmaXferCplt(DMA_HandleTypeDef *hdma);
+
+/**
+ * @brief 初始化TIM16更新事件触发的DMA波形输出
+ * TIM16按步进频率产生更新事件，每次更新由DMA1通道2把一个字写入GPIOA->BSRR
+ */
+void TM1639DmaInit(void)
+{
+    __HAL_RCC_TIM16_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    TIM16->CR1 = 0;
+    TIM16->PSC = 0;
+    TIM16->ARR = SystemCoreClock / TM1639_DMA_STEP_HZ - 1;
+    TIM16->EGR = TIM_EGR_UG; // 装载预分频和重装值
+    TIM16->SR = 0;
+    TIM16->DIER = TIM_DIER_UDE;
+
+    hdma_tim16_up.Instance = DMA1_Channel2;
+    hdma_tim16_up.Init.Request = DMA_REQUEST_TIM16_UP;
+    hdma_tim16_up.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_tim16_up.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim16_up.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim16_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_tim16_up.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma_tim16_up.Init.Mode = DMA_NORMAL;
+    hdma_tim16_up.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_tim16_up) != HAL_OK)
+    {
+        LOG_ERROR("TM1639 DMA init error.\n");
+        Error_Handler();
+    }
+    hdma_tim16_up.XferCpltCallback = TM1639DmaXferCplt;
+
+    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+}
+
+/**
+ * @brief 把字节序列编码为总线引脚的BSRR波形，见 TM1639WaveEncode
+ * @param buf 输出缓冲区，至少 length * 16 + 5 个字
+ * @param bytes 待发送字节
+ * @param length 字节数
+ * @param strobe_start 非0时在开头拉低STB
+ * @param strobe_end 非0时在结尾拉高STB
+ * @return uint16_t 生成的字数
+ */
+uint16_t TM1639DmaEncode(uint32_t *buf, const uint8_t *bytes, uint8_t length, uint8_t strobe_start, uint8_t strobe_end)
+{
+    return TM1639WaveEncode(buf, &wave_pins, bytes, length, strobe_start, strobe_end);
+}
+
+/**
+ * @brief DMA传输完成回调，停止定时器并唤醒等待任务
+ */
+static void TM1639DmaXferCplt(DMA_HandleTypeDef *hdma)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    (void)hdma;
+
+    TIM16->CR1 &= ~TIM_CR1_CEN;
+    dma_busy = 0;
+    if (waiting_task != NULL)
+    {
+        vTaskNotifyGiveFromISR(waiting_task, &xHigherPriorityTaskWoken);
+        waiting_task = NULL;
+        dma_given++;
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/**
+ * @brief 发送一段BSRR波形并等待传输完成
+ * @param words 字数
+ */
+static void TM1639DmaTransfer(uint16_t words)
+{
+    bool in_task = xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+
+    dma_busy = 1;
+    dma_given = 0;
+    waiting_task = in_task ? xTaskGetCurrentTaskHandle() : NULL;
+    TIM16->CNT = 0;
+    HAL_DMA_Start_IT(&hdma_tim16_up, (uint32_t)bsrr_buf, (uint32_t)&GPIOA->BSRR, words);
+    TIM16->CR1 |= TIM_CR1_CEN;
+
+    if (in_task)
+    {
+        uint32_t taken = 0;
+        while (dma_busy)
+        {
+            uint32_t n = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5));
+            if (n == 0)
+            {
+                // 超时：强制停止，避免总线卡死
+                TIM16->CR1 &= ~TIM_CR1_CEN;
+                HAL_DMA_Abort(&hdma_tim16_up);
+                waiting_task = NULL;
+                dma_busy = 0;
+                LOG_WARN("TM1639 DMA transfer timeout.\n");
+            }
+            taken += n;
+        }
+        if (taken < dma_given)
+        {
+            taken += ulTaskNotifyTake(pdTRUE, 0); // 进入等待前已完成，取走完成通知
+        }
+        if (taken > dma_given)
+        {
+            // 等待期间消耗了传输完成以外的通知(如显示内容发布)，补发一次
+            xTaskNotifyGive(xTaskGetCurrentTaskHandle());
+        }
+    }
+    else
+    {
+        while (dma_busy)
+        {
+        }
+    }
+}
+
+/**
+ * @brief 在一个STB窗口内发送一帧数据
+ * 超过单块容量时分块发送，块之间STB保持拉低，CLK保持高电平
+ * @param bytes 待发送字节
+ * @param length 字节数
+ */
+void TM1639DmaWriteFrame(const uint8_t *bytes, uint8_t length)
+{
+    uint8_t sent = 0;
+
+    do
+    {
+        uint8_t chunk = length - sent;
+        if (chunk > TM1639_DMA_CHUNK_BYTES)
+        {
+            chunk = TM1639_DMA_CHUNK_BYTES;
+        }
+        uint16_t words = TM1639DmaEncode(bsrr_buf, &bytes[sent], chunk, sent == 0, sent + chunk == length);
+        TM1639DmaTransfer(words);
+        sent += chunk;
+    } while (sent < length);
+}
@@ -0,0 +1,47 @@
+#include "tm1639_wave.h"
+
+// BSRR写入值：低16位置位，高16位复位，0表示保持
+#define BSRR_SET(pin) ((uint32_t)(pin))
+#define BSRR_RESET(pin) ((uint32_t)(pin) << 16)
+#define BSRR_IDLE 0U
+
+/**
+ * @brief 把字节序列编码为BSRR波形
+ * 每一位两步：CLK拉低同时设置DIO，然后CLK拉高(上升沿锁存)，低位先发
+ * @param buf 输出缓冲区，至少 length * 16 + 5 个字
+ * @param pins 引脚位
+ * @param bytes 待发送字节
+ * @param length 字节数
+ * @param strobe_start 非0时在开头拉低STB
+ * @param strobe_end 非0时在结尾拉高STB
+ * @return uint16_t 生成的字数
+ */
+uint16_t TM1639WaveEncode(uint32_t *buf, const TM1639WavePins_t *pins, const uint8_t *bytes, uint8_t length,
+                          uint8_t strobe_start, uint8_t strobe_end)
+{
+    uint16_t n = 0;
+
+    if (strobe_start)
+    {
+        buf[n++] = BSRR_RESET(pins->stb);
+        buf[n++] = BSRR_IDLE;
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+        uint8_t data = bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            buf[n++] = BSRR_RESET(pins->clk) | ((data & 1) ? BSRR_SET(pins->dio) : BSRR_RESET(pins->dio));
+            buf[n++] = BSRR_SET(pins->clk);
+            data >>= 1;
+        }
+    }
+    if (strobe_end)
+    {
+        // STB拉高后保持至少1us再开始下一帧
+        buf[n++] = BSRR_SET(pins->stb);
+        buf[n++] = BSRR_IDLE;
+        buf[n++] = BSRR_IDLE;
+    }
+    return n;
+}
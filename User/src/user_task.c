@@ -9,34 +9,32 @@
 #include "TM1639.h"
 #include "bsp_key.h"
 #include "console.h"
+#include "motor.h"
+#include "deal.h"
+#include "bsp_opto.h"
 #include "gpio.h"
 #include "test_key.h"
 
 /* 私有宏 ------------------------------------------------------------------*/
 #define TM1639_TASK_STACK 128
-#define WORK_TASK_STACK 128
+#define DEAL_TASK_STACK 128
 #define CONSOLE_TASK_STACK 128
-#define TEST_TASK_STACK 128
 
 #define START_TASK_PERIOD 100
-#define TM1639_TASK_PERIOD 10
-#define WORK_TASK_PERIOD 1
 #define CONSOLE_TASK_PERIOD 10
-#define TEST_TASK_PERIOD 1000
 
 /* 私有变量 ------------------------------------------------------------------*/
 TaskHandle_t TM1639_TaskHandle;
-TaskHandle_t Work_TaskHandle;
+TaskHandle_t Deal_TaskHandle;
 TaskHandle_t Console_TaskHandle;
-TaskHandle_t Test_TaskHandle;
 
 /* 函数声明 ------------------------------------------------------------------*/
 static void TM1639_task(void *pvParameters);
 static void Console_task(void *pvParameters);
-static void Work_task(void *pvParameters);
-static void Test_task(void *pvParameters);
+static void Deal_task(void *pvParameters);
 
-static void CreateTask(TaskFunction_t task, const char *name, uint16_t stackSize, TaskHandle_t *taskHandle);
+static void CreateTask(TaskFunction_t task, const char *name, uint16_t stackSize, osPriority priority, TaskHandle_t *taskHandle);
+static TickType_t DeadlineWait(TickType_t wait, uint32_t due);
 static void vTimerCallback(TimerHandle_t xTimer);
 /* 函数体 --------------------------------------------------------------------*/
 /**
@@ -48,6 +46,8 @@ void StartDefaultTask(void *argument)
 {
     (void)argument;
     SEGGER_RTT_Init();
+    MotorInit();
+    OptoInit();
     ConsoleInit();
     TimerHandle_t xTimer;
 
@@ -58,10 +58,9 @@ void StartDefaultTask(void *argument)
                           vTimerCallback);
 
     vTaskDelay(pdMS_TO_TICKS(100));
-    CreateTask(TM1639_task, "TM1639Task", TM1639_TASK_STACK, &TM1639_TaskHandle);
-    // CreateTask(Work_task, "WorkTask", CONSOLE_TASK_STACK, &Console_TaskHandle);
-    CreateTask(Console_task, "ConsoleTask", CONSOLE_TASK_STACK, &Console_TaskHandle);
-    CreateTask(Test_task, "TestTask", TEST_TASK_STACK, &Test_TaskHandle);
+    CreateTask(TM1639_task, "TM1639Task", TM1639_TASK_STACK, osPriorityNormal, &TM1639_TaskHandle);
+    CreateTask(Deal_task, "DealTask", DEAL_TASK_STACK, osPriorityAboveNormal, &Deal_TaskHandle); // 高于控制台，按键处理不拖慢运动
+    CreateTask(Console_task, "ConsoleTask", CONSOLE_TASK_STACK, osPriorityNormal, &Console_TaskHandle);
 
     if (xTimer != NULL)
     {
@@ -86,30 +85,61 @@ void StartDefaultTask(void *argument)
 static void TM1639_task(void *pvParameters)
 {
     (void)pvParameters;
+    DisplayInfo_t frame;
+    uint32_t version = 0;
+    uint32_t due = 0;
+    TickType_t wait = 0;
+
     for (;;)
     {
-        if (displayInfo.needUpdate)
+        if (DisplayFetch(&frame, &version))
         {
-            switch (displayInfo.content_type)
+            switch (frame.content_type)
             {
             case DIGITAL_CONTENT:
-                TM1639NumShow(displayInfo.digital_content, displayInfo.dot_content, displayInfo.start_pos, displayInfo.length);
+                TM1639AnimStop();
+                TM1639NumShow(frame.digital_content, frame.dot_content, frame.start_pos, frame.length);
                 break;
             case STRING_CONTENT:
-                TM1639LetterShow(displayInfo.string_content, displayInfo.length, displayInfo.dot_content);
+                TM1639AnimStop();
+                TM1639LetterShow(frame.string_content, frame.length, frame.dot_content);
                 break;
             case STRING_DIGITAL_CONTENT:
-                TM1639RemixShow(displayInfo.string_content, displayInfo.start_pos2, displayInfo.digital_content, (displayInfo.length - displayInfo.start_pos2), displayInfo.dot_content);
+                TM1639AnimStop();
+                TM1639RemixShow(frame.string_content, frame.start_pos2, frame.digital_content, (frame.length - frame.start_pos2), frame.dot_content);
                 break;
             case MARQUEE_CONTENT:
-                MarqueeDisplay(displayInfo.marQuee_index);
+                TM1639AnimMarquee(frame.marquee_dir, MARQUEE_PERIOD);
+                break;
+            case ROLL_CONTENT:
+                TM1639NumShow(frame.digital_content, frame.dot_content, frame.start_pos, frame.length);
+                TM1639AnimRoll(2, frame.roll_max, ROLL_PERIOD);
                 break;
             default:
                 break;
             }
-            displayInfo.needUpdate = false; // 重置更新标志
+            TM1639BlinkSet(frame.blink_mask, BLINK_PERIOD);
+            TM1639GovernorKick(); // 新内容视为活动，恢复亮度
+        }
+        wait = portMAX_DELAY;
+        if (TM1639GovernorTick(&due)) // 空闲降亮度/断电
+        {
+            wait = DeadlineWait(wait, due);
+        }
+        TM1639AnimTick(); // 推进闪烁和动画帧
+        TM1639Flush();    // 一次性下发变化的显示内容
+        if (TM1639KeyPoll(&due) && KeyScan() > 0) // 同一时隙内读键，本任务是总线的唯一访问者
+        {
+            ConsoleTaskNotify(); // 有新按键事件
+        }
+        wait = DeadlineWait(wait, due);
+        if (TM1639GetPowerState() != TM1639_POWER_OFF && TM1639AnimNextDue(&due))
+        {
+            wait = DeadlineWait(wait, due);
         }
-        vTaskDelay(pdMS_TO_TICKS(TM1639_TASK_PERIOD));
+
+        // 等待新内容发布，最多等到最近的截止时刻
+        ulTaskNotifyTake(pdTRUE, wait);
     }
 }
 
@@ -121,28 +151,39 @@ static void TM1639_task(void *pvParameters)
 static void Console_task(void *pvParameters)
 {
     (void)pvParameters;
+    KeyEvent_t event;
+    bool handled = false;
+
     for (;;)
     {
-        KeyScan();           // 按键扫描
-        TM1639KeyScan();     // TM1639按键扫描
-        ConsoleModeSwitch(); // 更新运行模式
+        // 有按键事件时立即唤醒，否则按周期处理与按键无关的逻辑
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONSOLE_TASK_PERIOD));
 
-        vTaskDelay(pdMS_TO_TICKS(CONSOLE_TASK_PERIOD));
+        handled = ConsoleKeyIrq(); // 先处理触摸/电源键中断
+        while (KeyEventGet(&event)) // 逐个处理，事件不会丢失或重复
+        {
+            ConsoleModeSwitch(&event);
+            handled = true;
+        }
+        if (!handled)
+        {
+            ConsoleModeSwitch(NULL); // 更新运行模式
+        }
     }
 }
 
 /**
- * @brief  Work_task 工作任务
+ * @brief  Deal_task 发牌引擎任务
+ * 光耦边沿中断或控制台请求时被通知唤醒，否则睡到引擎给出的截止时刻
  * @param  argument: 未使用
  * @retval None
  */
-static void Work_task(void *pvParameters)
+static void Deal_task(void *pvParameters)
 {
     (void)pvParameters;
     for (;;)
     {
-        WorkModeSwitch();
-        vTaskDelay(pdMS_TO_TICKS(WORK_TASK_PERIOD));
+        ulTaskNotifyTake(pdTRUE, DealRun());
     }
 }
 
@@ -158,36 +199,23 @@ void printSystemClockFrequency(void)
     LOG_DEBUG("System Clock Frequency: %lu Hz\n", sysclk_freq);
 }
 
-/**
- * @brief  Test_task 测试任务
- * @param  argument: 未使用
- * @retval None
- */
-static void Test_task(void *pvParameters)
-{
-    (void)pvParameters;
-    for (;;)
-    {
-        vTaskDelay(pdMS_TO_TICKS(TEST_TASK_PERIOD));
-    }
-}
-
 /**
  * @brief  CreateTask 任务创建函数
  * @param  task: 任务函数
  * @param  name: 任务名称
  * @param  stackSize: 任务堆栈大小
+ * @param  priority: 任务优先级
  * @param  taskHandle: 任务句柄
 
  * @retval None
  */
-static void CreateTask(TaskFunction_t task, const char *name, uint16_t stackSize, TaskHandle_t *taskHandle)
+static void CreateTask(TaskFunction_t task, const char *name, uint16_t stackSize, osPriority priority, TaskHandle_t *taskHandle)
 {
     size_t HeapSize_before = 0;
     size_t HeapSize_after = 0;
 
     HeapSize_before = xPortGetFreeHeapSize();
-    BaseType_t xReturned = xTaskCreate(task, name, stackSize, NULL, osPriorityNormal, taskHandle);
+    BaseType_t xReturned = xTaskCreate(task, name, stackSize, NULL, priority, taskHandle);
     HeapSize_after = xPortGetFreeHeapSize();
     if (xReturned == pdPASS)
     {
@@ -199,6 +227,60 @@ static void CreateTask(TaskFunction_t task, const char *name, uint16_t stackSize
     }
 }
 
+/**
+ * @brief  DeadlineWait 取等待时间与到截止时刻时间中较小者
+ * @param  wait: 当前等待时间
+ * @param  due: 截止时刻(tick)
+ * @retval 等待时间
+ */
+static TickType_t DeadlineWait(TickType_t wait, uint32_t due)
+{
+    int32_t remain = (int32_t)(due - xTaskGetTickCount());
+
+    if (remain < 0)
+    {
+        remain = 0;
+    }
+    return ((TickType_t)remain < wait) ? (TickType_t)remain : wait;
+}
+
+/**
+ * @brief  TM1639TaskNotify 通知显示任务有新内容
+ * @retval None
+ */
+void TM1639TaskNotify(void)
+{
+    if (TM1639_TaskHandle != NULL)
+    {
+        xTaskNotifyGive(TM1639_TaskHandle);
+    }
+}
+
+/**
+ * @brief  ConsoleTaskNotify 通知控制台任务有新按键事件
+ * @retval None
+ */
+void ConsoleTaskNotify(void)
+{
+    if (Console_TaskHandle != NULL)
+    {
+        xTaskNotifyGive(Console_TaskHandle);
+    }
+}
+
+/**
+ * @brief  ConsoleTaskNotifyFromISR 在中断中通知控制台任务
+ * @param  woken: 输出是否需要切换任务
+ * @retval None
+ */
+void ConsoleTaskNotifyFromISR(BaseType_t *woken)
+{
+    if (Console_TaskHandle != NULL)
+    {
+        vTaskNotifyGiveFromISR(Console_TaskHandle, woken);
+    }
+}
+
 /**
  * @brief  vTimerCallback 软件定时器回调
  * @param  xTimer: 未使用
@@ -208,4 +290,30 @@ static void vTimerCallback(TimerHandle_t xTimer)
 {
     (void)xTimer; // 如果不使用 xTimer 参数，可以避免编译器警告
     ConsoleMsHandle();
+    MotorRampTick();
+}
+
+/**
+ * @brief  DealTaskNotify 通知发牌引擎任务有新请求
+ * @retval None
+ */
+void DealTaskNotify(void)
+{
+    if (Deal_TaskHandle != NULL)
+    {
+        xTaskNotifyGive(Deal_TaskHandle);
+    }
+}
+
+/**
+ * @brief  DealTaskNotifyFromISR 在中断中通知发牌引擎任务
+ * @param  woken: 输出是否需要切换任务
+ * @retval None
+ */
+void DealTaskNotifyFromISR(BaseType_t *woken)
+{
+    if (Deal_TaskHandle != NULL)
+    {
+        vTaskNotifyGiveFromISR(Deal_TaskHandle, woken);
+    }
 }
@@ -0,0 +1,40 @@
+#ifndef _TEST_H_
+#define _TEST_H_
+// 主机单元测试的最小断言框架，每个测试程序失败时返回非0
+
+#include <stdio.h>
+
+static int test_checks = 0;
+static int test_failures = 0;
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        test_checks++;                                                         \
+        if (!(cond))                                                           \
+        {                                                                      \
+            test_failures++;                                                   \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+        }                                                                      \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+    do                                                                         \
+    {                                                                          \
+        long _a = (long)(a), _b = (long)(b);                                   \
+        test_checks++;                                                         \
+        if (_a != _b)                                                          \
+        {                                                                      \
+            test_failures++;                                                   \
+            printf("%s:%d: CHECK_EQ(%s, %s) failed: %ld != %ld\n",             \
+                   __FILE__, __LINE__, #a, #b, _a, _b);                        \
+        }                                                                      \
+    } while (0)
+
+static inline int TestReport(const char *name)
+{
+    printf("%s: %d checks, %d failures\n", name, test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
+
+#endif // _TEST_H_
@@ -0,0 +1,239 @@
+// 座位规划(deal_plan.c)主机测试：玩家数 0 ~ SEAT_MAX、两个发牌方向、均分和标定座位表
+#include <string.h>
+#include "test.h"
+#include "deal_plan.h"
+
+/* 座位表桩：与 motor.c 的 MotorSeatGet 规则相同 ----------------------------*/
+static uint8_t seat_table[SEAT_MAX];
+static uint8_t seat_count = 0;
+
+void MotorSeatSet(const uint8_t *sector, uint8_t count)
+{
+    memset(seat_table, 0, sizeof(seat_table));
+    memcpy(seat_table, sector, count);
+    seat_count = count;
+}
+
+uint8_t MotorSeatGet(uint8_t count, uint8_t seat)
+{
+    if (count == 0 || count != seat_count || seat >= count)
+    {
+        return SEAT_NONE;
+    }
+    return seat_table[seat];
+}
+
+/* 辅助 ----------------------------------------------------------------------*/
+static const MotorDirection_e dirs[2] = {MOTOR_FORWARD, MOTOR_REVERSE};
+
+// 各玩家数的标定座位表：不均匀分布，玩家数为 n 时取前 n 个
+static const uint8_t calibrated[SEAT_MAX] = {1, 2, 4, 7, 8, 10, 11, 0};
+
+static uint8_t Nearest(uint8_t from, uint8_t to)
+{
+    uint8_t fwd = DealSectorGap(from, to, MOTOR_FORWARD);
+    uint8_t rev = DealSectorGap(from, to, MOTOR_REVERSE);
+    return (fwd < rev) ? fwd : rev;
+}
+
+// 按 order 的顺序发一轮的行程：较近方向转到首座位，之后沿 dir 依次转到各座位
+static uint16_t Travel(uint8_t players, MotorDirection_e dir, uint8_t heading, const uint8_t *order, uint8_t count)
+{
+    uint16_t travel = Nearest(heading, DealSeatSector(players, order[0]));
+    uint8_t i;
+
+    for (i = 1; i < count; i++)
+    {
+        travel += DealSectorGap(DealSeatSector(players, order[i - 1]), DealSeatSector(players, order[i]), dir);
+    }
+    return travel;
+}
+
+static int IsPermutation(const uint8_t *order, uint8_t count)
+{
+    uint8_t seen[SEAT_MAX] = {0};
+    uint8_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (order[i] >= count || seen[order[i]])
+        {
+            return 0;
+        }
+        seen[order[i]] = 1;
+    }
+    return 1;
+}
+
+// 检查一个玩家数/方向/座位表组合下的两种规划
+static void CheckPlans(uint8_t players, MotorDirection_e dir)
+{
+    uint8_t order[SEAT_MAX], alt[SEAT_MAX];
+    uint8_t heading, count, i, k, gap, max_gap;
+    uint16_t travel, best;
+
+    for (heading = 0; heading < ROTATE_SECTORS; heading++)
+    {
+        memset(order, 0xEE, sizeof(order));
+        count = DealSeatPlan(players, dir, heading, order);
+        CHECK_EQ(count, players);
+        if (count == 0)
+        {
+            continue;
+        }
+        CHECK(IsPermutation(order, count));
+
+        // 沿 dir 绕行不超过一周，且行程不大于任何其他起点
+        travel = Travel(players, dir, heading, order, count);
+        CHECK((unsigned)(travel - Nearest(heading, DealSeatSector(players, order[0]))) < ROTATE_SECTORS);
+        best = 0xFFFF;
+        for (k = 0; k < count; k++)
+        {
+            for (i = 0; i < count; i++)
+            {
+                alt[i] = order[(k + i) % count];
+            }
+            if (Travel(players, dir, heading, alt, count) < best)
+            {
+                best = Travel(players, dir, heading, alt, count);
+            }
+        }
+        CHECK_EQ(travel, best);
+    }
+
+    count = DealSwayPlan(players, dir, order);
+    CHECK_EQ(count, players);
+    if (count == 0)
+    {
+        return;
+    }
+    CHECK(IsPermutation(order, count));
+    // 末座位到首座位(沿 dir)是最大的空档，摆动范围不跨过它
+    max_gap = 0;
+    for (i = 0; i < count; i++)
+    {
+        gap = DealSectorGap(DealSeatSector(players, order[i]), DealSeatSector(players, order[(i + 1) % count]), dir);
+        gap = (gap == 0) ? ROTATE_SECTORS : gap;
+        if (gap > max_gap)
+        {
+            max_gap = gap;
+        }
+    }
+    gap = DealSectorGap(DealSeatSector(players, order[count - 1]), DealSeatSector(players, order[0]), dir);
+    gap = (gap == 0) ? ROTATE_SECTORS : gap;
+    CHECK_EQ(gap, max_gap);
+}
+
+/* 测试 ----------------------------------------------------------------------*/
+static void TestSectorGap(void)
+{
+    CHECK_EQ(DealSectorGap(0, 0, MOTOR_FORWARD), 0);
+    CHECK_EQ(DealSectorGap(2, 5, MOTOR_FORWARD), 3);
+    CHECK_EQ(DealSectorGap(2, 5, MOTOR_REVERSE), ROTATE_SECTORS - 3);
+    CHECK_EQ(DealSectorGap(11, 0, MOTOR_FORWARD), 1);
+    CHECK_EQ(DealSectorGap(0, 11, MOTOR_REVERSE), 1);
+}
+
+static void TestShortest(void)
+{
+    CHECK_EQ(DealSectorShortest(0, 2, MOTOR_FORWARD), MOTOR_FORWARD);
+    CHECK_EQ(DealSectorShortest(0, 2, MOTOR_REVERSE), MOTOR_FORWARD);
+    CHECK_EQ(DealSectorShortest(0, 10, MOTOR_FORWARD), MOTOR_REVERSE);
+    CHECK_EQ(DealSectorShortest(0, 10, MOTOR_REVERSE), MOTOR_REVERSE);
+    // 距离相等(半周)和原地时按偏好方向
+    CHECK_EQ(DealSectorShortest(1, 1 + ROTATE_SECTORS / 2, MOTOR_FORWARD), MOTOR_FORWARD);
+    CHECK_EQ(DealSectorShortest(1, 1 + ROTATE_SECTORS / 2, MOTOR_REVERSE), MOTOR_REVERSE);
+    CHECK_EQ(DealSectorShortest(4, 4, MOTOR_REVERSE), MOTOR_REVERSE);
+}
+
+static void TestSeatSector(void)
+{
+    uint8_t players, seat;
+
+    MotorSeatSet(calibrated, 0);
+    CHECK_EQ(DealSeatSector(0, 0), 0);
+    for (players = 1; players <= SEAT_MAX; players++)
+    {
+        for (seat = 0; seat < players; seat++)
+        {
+            CHECK_EQ(DealSeatSector(players, seat), seat * ROTATE_SECTORS / players);
+        }
+    }
+    // 只有玩家数与标定时相同才使用座位表
+    MotorSeatSet(calibrated, 3);
+    CHECK_EQ(DealSeatSector(3, 2), calibrated[2]);
+    CHECK_EQ(DealSeatSector(4, 2), 2 * ROTATE_SECTORS / 4);
+}
+
+static void TestAllPlayerCounts(void)
+{
+    uint8_t players, d;
+
+    for (players = 0; players <= SEAT_MAX; players++)
+    {
+        for (d = 0; d < 2; d++)
+        {
+            MotorSeatSet(calibrated, 0);
+            CheckPlans(players, dirs[d]);
+            MotorSeatSet(calibrated, players);
+            CheckPlans(players, dirs[d]);
+        }
+    }
+}
+
+static void TestTieBreak(void)
+{
+    uint8_t order[SEAT_MAX];
+
+    MotorSeatSet(calibrated, 0);
+    // 2人座位在 0、6，航向 3：两个起点行程相同，取沿发牌方向先到的座位
+    CHECK_EQ(DealSeatPlan(2, MOTOR_FORWARD, 3, order), 2);
+    CHECK_EQ(order[0], 1);
+    CHECK_EQ(order[1], 0);
+    CHECK_EQ(DealSeatPlan(2, MOTOR_REVERSE, 3, order), 2);
+    CHECK_EQ(order[0], 0);
+    CHECK_EQ(order[1], 1);
+    // 航向正对座位时从该座位开始
+    DealSeatPlan(4, MOTOR_FORWARD, 9, order);
+    CHECK_EQ(order[0], 3);
+    DealSeatPlan(4, MOTOR_REVERSE, 9, order);
+    CHECK_EQ(order[0], 3);
+
+    // 均分时各空档相等，摆动从座位0开始
+    CHECK_EQ(DealSwayPlan(3, MOTOR_FORWARD, order), 3);
+    CHECK_EQ(order[0], 0);
+    CHECK_EQ(order[1], 1);
+    CHECK_EQ(order[2], 2);
+    CHECK_EQ(DealSwayPlan(3, MOTOR_REVERSE, order), 3);
+    CHECK_EQ(order[0], 0);
+    CHECK_EQ(order[1], 2);
+    CHECK_EQ(order[2], 1);
+}
+
+static void TestSwayCalibrated(void)
+{
+    static const uint8_t wrap[3] = {10, 0, 2};
+    uint8_t order[SEAT_MAX];
+
+    // 座位跨过原点槽：摆动范围 10 -> 0 -> 2，不经过 2 ~ 10 的空档
+    MotorSeatSet(wrap, 3);
+    DealSwayPlan(3, MOTOR_FORWARD, order);
+    CHECK_EQ(order[0], 0);
+    CHECK_EQ(order[1], 1);
+    CHECK_EQ(order[2], 2);
+    DealSwayPlan(3, MOTOR_REVERSE, order);
+    CHECK_EQ(order[0], 2);
+    CHECK_EQ(order[1], 1);
+    CHECK_EQ(order[2], 0);
+}
+
+int main(void)
+{
+    TestSectorGap();
+    TestShortest();
+    TestSeatSector();
+    TestAllPlayerCounts();
+    TestTieBreak();
+    TestSwayCalibrated();
+    return TestReport("test_deal_plan");
+}
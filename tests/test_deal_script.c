@@ -0,0 +1,140 @@
+// 发牌脚本校验(deal_script.c)主机测试：内置脚本全部通过，错误脚本给出对应的错误码
+#include "test.h"
+#include "deal_script.h"
+
+#define SCRIPT(name, players, cards, base) {name, sizeof(name), players, cards, base}
+
+static DealScriptErr_e Check(const DealScript_t *script, uint8_t players)
+{
+    uint16_t seat_cards[SEAT_MAX], base_cards;
+
+    return DealScriptCheck(script, players, seat_cards, &base_cards);
+}
+
+/* 测试 ----------------------------------------------------------------------*/
+static void TestBuiltin(void)
+{
+    uint16_t seat_cards[SEAT_MAX], base_cards;
+    uint8_t i, players, s, used;
+
+    CHECK(deal_script_num > 0);
+    for (i = 0; i < deal_script_num; i++)
+    {
+        // 菜单玩家数 0 ~ SEAT_MAX，固定玩家数的脚本不受菜单影响
+        for (players = 0; players <= SEAT_MAX; players++)
+        {
+            used = DealScriptPlayers(&deal_script[i], players);
+            if (used == 0)
+            {
+                CHECK_EQ(DealScriptCheck(&deal_script[i], players, seat_cards, &base_cards), DS_ERR_SEAT);
+                continue;
+            }
+            CHECK_EQ(DealScriptCheck(&deal_script[i], players, seat_cards, &base_cards), DS_OK);
+            for (s = 0; s < SEAT_MAX; s++)
+            {
+                CHECK_EQ(seat_cards[s], (s < used) ? deal_script[i].cards : 0);
+            }
+            CHECK_EQ(base_cards, deal_script[i].base);
+        }
+    }
+}
+
+static void TestHoldem(void)
+{
+    const DealScript_t *holdem = &deal_script[2]; // 内置脚本顺序：斗地主、掼蛋、德州扑克
+    uint8_t players;
+
+    // 德州扑克跟随菜单玩家数
+    CHECK_EQ(holdem->players, 0);
+    CHECK_EQ(Check(holdem, 0), DS_ERR_SEAT);
+    for (players = 1; players <= SEAT_MAX; players++)
+    {
+        CHECK_EQ(DealScriptPlayers(holdem, players), players);
+        CHECK_EQ(Check(holdem, players), DS_OK);
+    }
+    CHECK_EQ(DealScriptPlayers(holdem, SEAT_MAX + 1), SEAT_MAX);
+}
+
+static void TestBlock(void)
+{
+    static const uint8_t extra_next[] = {DS_ROTATE_TO(0), DS_EJECT(1), DS_NEXT(), DS_END()};
+    static const uint8_t open_block[] = {DS_REPEAT(2), DS_ROTATE_TO(0), DS_EJECT(1), DS_END()};
+    static const uint8_t max_depth[] = {
+        DS_REPEAT(2), DS_REPEAT(2), DS_FOR_EACH_SEAT(), DS_EJECT(1), DS_NEXT(), DS_NEXT(), DS_NEXT(), DS_END()};
+    static const uint8_t too_deep[] = {
+        DS_REPEAT(2), DS_REPEAT(2), DS_REPEAT(2), DS_FOR_EACH_SEAT(), DS_EJECT(1),
+        DS_NEXT(), DS_NEXT(), DS_NEXT(), DS_NEXT(), DS_END()};
+    const DealScript_t s_extra = SCRIPT(extra_next, 2, 0, 0);
+    const DealScript_t s_open = SCRIPT(open_block, 2, 0, 0);
+    const DealScript_t s_max = SCRIPT(max_depth, 2, 4, 0);
+    const DealScript_t s_deep = SCRIPT(too_deep, 2, 8, 0);
+
+    CHECK_EQ(Check(&s_extra, 0), DS_ERR_BLOCK);
+    CHECK_EQ(Check(&s_open, 0), DS_ERR_BLOCK);
+    CHECK_EQ(Check(&s_max, 0), DS_OK);
+    CHECK_EQ(Check(&s_deep, 0), DS_ERR_BLOCK);
+    CHECK_EQ(DealScriptBlockEnd(&s_max, 0), 12);
+    CHECK_EQ(DealScriptBlockEnd(&s_max, 4), 8);
+    CHECK_EQ(DealScriptBlockEnd(&s_open, 0), s_open.size);
+}
+
+static void TestNest(void)
+{
+    static const uint8_t rotate_in_each[] = {DS_FOR_EACH_SEAT(), DS_ROTATE_TO(0), DS_EJECT(1), DS_NEXT(), DS_END()};
+    static const uint8_t base_in_each[] = {DS_FOR_EACH_SEAT(), DS_BASE_PILE(1), DS_NEXT(), DS_END()};
+    static const uint8_t each_in_each[] = {
+        DS_FOR_EACH_SEAT(), DS_FOR_EACH_SEAT(), DS_EJECT(1), DS_NEXT(), DS_NEXT(), DS_END()};
+    const DealScript_t s_rotate = SCRIPT(rotate_in_each, 2, 1, 0);
+    const DealScript_t s_base = SCRIPT(base_in_each, 2, 0, 2);
+    const DealScript_t s_each = SCRIPT(each_in_each, 2, 1, 0);
+
+    CHECK_EQ(Check(&s_rotate, 0), DS_ERR_NEST);
+    CHECK_EQ(Check(&s_base, 0), DS_ERR_NEST);
+    CHECK_EQ(Check(&s_each, 0), DS_ERR_NEST);
+}
+
+static void TestCount(void)
+{
+    static const uint8_t three_each[] = {DS_REPEAT(3), DS_FOR_EACH_SEAT(), DS_EJECT(1), DS_NEXT(), DS_NEXT(), DS_BASE_PILE(2), DS_END()};
+    static const uint8_t uneven[] = {DS_ROTATE_TO(0), DS_EJECT(2), DS_ROTATE_TO(1), DS_EJECT(1), DS_END()};
+    const DealScript_t s_ok = SCRIPT(three_each, 4, 3, 2);
+    const DealScript_t s_seat = SCRIPT(three_each, 4, 4, 2);
+    const DealScript_t s_base = SCRIPT(three_each, 4, 3, 3);
+    const DealScript_t s_uneven = SCRIPT(uneven, 2, 2, 0);
+
+    CHECK_EQ(Check(&s_ok, 0), DS_OK);
+    CHECK_EQ(Check(&s_seat, 0), DS_ERR_COUNT);
+    CHECK_EQ(Check(&s_base, 0), DS_ERR_COUNT);
+    CHECK_EQ(Check(&s_uneven, 0), DS_ERR_COUNT);
+}
+
+static void TestSeatAndOp(void)
+{
+    static const uint8_t seat_range[] = {DS_ROTATE_TO(2), DS_EJECT(1), DS_END()};
+    static const uint8_t no_pos[] = {DS_EJECT(1), DS_END()};
+    static const uint8_t after_each[] = {DS_FOR_EACH_SEAT(), DS_EJECT(1), DS_NEXT(), DS_EJECT(1), DS_END()};
+    static const uint8_t no_end[] = {DS_ROTATE_TO(0), DS_EJECT(1)};
+    static const uint8_t bad_op[] = {DS_OP_NUM, 0, DS_END()};
+    const DealScript_t s_range = SCRIPT(seat_range, 2, 1, 0);
+    const DealScript_t s_pos = SCRIPT(no_pos, 1, 1, 0);
+    const DealScript_t s_after = SCRIPT(after_each, 2, 2, 0);
+    const DealScript_t s_end = SCRIPT(no_end, 1, 1, 0);
+    const DealScript_t s_op = SCRIPT(bad_op, 1, 0, 0);
+
+    CHECK_EQ(Check(&s_range, 0), DS_ERR_SEAT);
+    CHECK_EQ(Check(&s_pos, 0), DS_ERR_SEAT);
+    CHECK_EQ(Check(&s_after, 0), DS_ERR_SEAT);   // 块结束后位置取决于航向，需要重新确定
+    CHECK_EQ(Check(&s_end, 0), DS_ERR_OP);
+    CHECK_EQ(Check(&s_op, 0), DS_ERR_OP);
+}
+
+int main(void)
+{
+    TestBuiltin();
+    TestHoldem();
+    TestBlock();
+    TestNest();
+    TestCount();
+    TestSeatAndOp();
+    return TestReport("test_deal_script");
+}
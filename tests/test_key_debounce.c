@@ -0,0 +1,315 @@
+// 按键消抖(key_debounce.c)主机测试：回放抖动采样序列，检查消抖延迟(采样数)和输出的事件
+#include <string.h>
+#include <time.h>
+#include "test.h"
+#include "key_debounce.h"
+
+#define SCAN_MS 4       // 有按键活动时的扫描周期，同 TM1639_KEY_SCAN_FAST
+#define EVENT_MAX 256
+
+typedef struct
+{
+    uint8_t key;
+    uint8_t type;
+    uint8_t step;
+    uint32_t tick;
+} Event_t;
+
+static Event_t events[EVENT_MAX];
+static uint16_t event_count;
+
+static void Sink(uint8_t key, KeyState_e type, uint32_t tick, uint8_t step)
+{
+    if (event_count < EVENT_MAX)
+    {
+        events[event_count].key = key;
+        events[event_count].type = (uint8_t)type;
+        events[event_count].step = step;
+        events[event_count].tick = tick;
+    }
+    event_count++;
+}
+
+static KeyDebounce_t kd;
+static uint32_t now;
+
+static void Reset(void)
+{
+    const KeyDebounce_t init = KEY_DEBOUNCE_INIT;
+
+    kd = init;
+    now = 1000;
+    event_count = 0;
+}
+
+// 回放一个按键的采样序列，'1'为按下；返回序列最后一个采样的序号
+static uint32_t Play(uint8_t key, const char *trace)
+{
+    uint32_t n = 0;
+
+    for (; *trace; trace++)
+    {
+        if (*trace == ' ')
+        {
+            continue;
+        }
+        KeyDebounceUpdate(&kd, (*trace == '1') ? (uint8_t)(1U << key) : 0, now, Sink);
+        now += SCAN_MS;
+        n++;
+    }
+    return n;
+}
+
+// 保持同一采样 ms 毫秒
+static void Hold(uint8_t sample, uint32_t ms)
+{
+    for (uint32_t t = 0; t < ms; t += SCAN_MS)
+    {
+        KeyDebounceUpdate(&kd, sample, now, Sink);
+        now += SCAN_MS;
+    }
+}
+
+// 事件相对于序列开始的采样序号(从1起)
+static uint32_t SampleOf(const Event_t *event, uint32_t start)
+{
+    return (event->tick - start) / SCAN_MS + 1;
+}
+
+/* 测试 ----------------------------------------------------------------------*/
+static void TestCleanEdges(void)
+{
+    uint32_t start;
+
+    // 干净的按下/松开：第4个不同的采样翻转
+    Reset();
+    start = now;
+    Play(0, "0000 1111 1111 0000 0000");
+    CHECK_EQ(event_count, 2);
+    CHECK_EQ(events[0].type, KEY_PRESSED);
+    CHECK_EQ(SampleOf(&events[0], start), 4 + 4);
+    CHECK_EQ(events[1].type, KEY_CLICKED);
+    CHECK_EQ(SampleOf(&events[1], start), 12 + 4);
+    CHECK_EQ(kd.keys[0].state, KEY_IDLE);
+    CHECK_EQ(kd.busy, 0);
+}
+
+static void TestBounce(void)
+{
+    // 录制的机械键抖动：按下和松开沿各抖动约20ms
+    static const char *press = "0000 0100 1011 0110 1111 1111 1111";
+    static const char *release = "1110 1001 0100 0000 0000";
+    uint32_t start;
+
+    Reset();
+    start = now;
+    Play(0, press);
+    // 最后一次抖动(第16个采样为0)之后连续4个按下采样才翻转
+    CHECK_EQ(event_count, 1);
+    CHECK_EQ(events[0].type, KEY_PRESSED);
+    CHECK_EQ(SampleOf(&events[0], start), 16 + 4);
+
+    start = now;
+    Play(0, release);
+    CHECK_EQ(event_count, 2);
+    CHECK_EQ(events[1].type, KEY_CLICKED);
+    // 最后一次抖动(第10个采样为1)之后连续4个松开采样才翻转
+    CHECK_EQ(SampleOf(&events[1], start), 10 + 4);
+}
+
+static void TestGlitch(void)
+{
+    // 少于4个采样的干扰不产生事件
+    Reset();
+    Play(0, "0000 1110 0000 1110 1101 1011 0000 0000");
+    CHECK_EQ(event_count, 0);
+    CHECK_EQ(kd.down, 0);
+    CHECK_EQ(kd.busy, 0);
+
+    Reset();
+    Play(0, "1111 0001 0001 0110 1111");
+    CHECK_EQ(event_count, 1);
+    CHECK_EQ(events[0].type, KEY_PRESSED);
+}
+
+static void TestLongPress(void)
+{
+    uint16_t i;
+
+    Reset();
+    Hold(1U << 4, 2200);
+    Hold(0, 40);
+    CHECK_EQ(event_count, 3);
+    CHECK_EQ(events[0].type, KEY_PRESSED);
+    CHECK_EQ(events[1].type, KEY_LONG_PRESSED);
+    CHECK(events[1].tick - events[0].tick > KEY_MS_TO_TICKS(KEY_LONG_PRESS_THRESHOLD));
+    CHECK(events[1].tick - events[0].tick <= KEY_MS_TO_TICKS(KEY_LONG_PRESS_THRESHOLD) + SCAN_MS);
+    CHECK_EQ(events[2].type, KEY_RELEASED);
+    for (i = 0; i < event_count; i++)
+    {
+        CHECK_EQ(events[i].key, 4);
+    }
+
+    // 超过单击时长但不到长按时长，松开为 RELEASED
+    Reset();
+    Hold(1U << 0, 800);
+    Hold(0, 40);
+    CHECK_EQ(event_count, 2);
+    CHECK_EQ(events[1].type, KEY_RELEASED);
+}
+
+static void TestRepeat(void)
+{
+    uint32_t press, last = 0, interval, expect = KEY_REPEAT_START;
+    uint16_t i, repeats = 0, decade = 0;
+
+    Reset();
+    Hold(1U << 1, 4000);
+    Hold(0, 40);
+    CHECK_EQ(events[0].type, KEY_PRESSED);
+    press = events[0].tick;
+    for (i = 1; i < event_count && i < EVENT_MAX; i++)
+    {
+        if (events[i].type != KEY_REPEAT)
+        {
+            continue;
+        }
+        CHECK_EQ(events[i].key, 1);
+        if (repeats == 0)
+        {
+            // 首次连发在按下后 KEY_REPEAT_DELAY
+            CHECK(events[i].tick - press >= KEY_MS_TO_TICKS(KEY_REPEAT_DELAY));
+            CHECK(events[i].tick - press < KEY_MS_TO_TICKS(KEY_REPEAT_DELAY) + SCAN_MS);
+        }
+        else
+        {
+            // 扫描周期量化，实际间隔在上次连发时设定的间隔之后一个周期内
+            interval = events[i].tick - last;
+            CHECK(interval >= KEY_MS_TO_TICKS(expect));
+            CHECK(interval < KEY_MS_TO_TICKS(expect) + SCAN_MS);
+        }
+        // 每次连发间隔缩短，十位跳步时固定
+        if (events[i].step == 10)
+        {
+            expect = KEY_REPEAT_DECADE_INTERVAL;
+        }
+        else
+        {
+            expect = (expect > KEY_REPEAT_MIN + KEY_REPEAT_ACCEL) ? expect - KEY_REPEAT_ACCEL : KEY_REPEAT_MIN;
+        }
+        if (events[i].tick - press >= KEY_MS_TO_TICKS(KEY_REPEAT_DECADE))
+        {
+            CHECK_EQ(events[i].step, 10);
+            decade++;
+        }
+        else
+        {
+            CHECK_EQ(events[i].step, 1);
+        }
+        last = events[i].tick;
+        repeats++;
+    }
+    CHECK(repeats > 10);
+    CHECK(decade >= 3);
+    // 连发之后松开不算单击
+    CHECK_EQ(events[event_count - 1].type, KEY_RELEASED);
+
+    // 非连发键按住不连发
+    Reset();
+    Hold(1U << 3, 1500);
+    CHECK_EQ(event_count, 1);
+}
+
+// 去掉分组用的空格，返回采样数
+static uint16_t Samples(const char *trace, char *out)
+{
+    uint16_t n = 0;
+
+    for (; *trace; trace++)
+    {
+        if (*trace != ' ')
+        {
+            out[n++] = *trace;
+        }
+    }
+    return n;
+}
+
+static void TestParallel(void)
+{
+    // 两个键同时抖动，各自独立消抖
+    char a[64], b[64];
+    uint16_t na = Samples("0101 1111 1111 1111 0000 0000", a);
+    uint16_t nb = Samples("0000 0011 0111 1111 1111 1110 0100 0000", b);
+    uint32_t start;
+    uint16_t i, pressed_a = 0, pressed_b = 0;
+    uint8_t sample;
+
+    Reset();
+    start = now;
+    for (i = 0; i < na || i < nb; i++)
+    {
+        sample = 0;
+        if (i < na && a[i] == '1')
+        {
+            sample |= 1U << 0;
+        }
+        if (i < nb && b[i] == '1')
+        {
+            sample |= 1U << 5;
+        }
+        KeyDebounceUpdate(&kd, sample, now, Sink);
+        now += SCAN_MS;
+    }
+    for (i = 0; i < event_count; i++)
+    {
+        if (events[i].type == KEY_PRESSED && events[i].key == 0)
+        {
+            pressed_a++;
+            CHECK_EQ(SampleOf(&events[i], start), 3 + 4);
+        }
+        if (events[i].type == KEY_PRESSED && events[i].key == 5)
+        {
+            pressed_b++;
+            CHECK_EQ(SampleOf(&events[i], start), 9 + 4);
+        }
+    }
+    CHECK_EQ(pressed_a, 1);
+    CHECK_EQ(pressed_b, 1);
+    CHECK_EQ(kd.down, 0);
+}
+
+static void Benchmark(void)
+{
+    uint32_t seed = 1, n;
+    uint8_t sample = 0;
+    clock_t begin;
+    double ns;
+
+    Reset();
+    begin = clock();
+    for (n = 0; n < 2000000U; n++)
+    {
+        seed = seed * 1103515245U + 12345U;
+        if ((seed >> 24) < 8)
+        {
+            sample ^= (uint8_t)(1U << ((seed >> 16) % NUM_KEYS)); // 随机翻转一位模拟抖动
+        }
+        KeyDebounceUpdate(&kd, sample, now, Sink);
+        now += SCAN_MS;
+    }
+    ns = (double)(clock() - begin) * 1e9 / CLOCKS_PER_SEC / n;
+    printf("KeyDebounceUpdate: %.1f ns/sample (host)\n", ns);
+}
+
+int main(void)
+{
+    TestCleanEdges();
+    TestBounce();
+    TestGlitch();
+    TestLongPress();
+    TestRepeat();
+    TestParallel();
+    Benchmark();
+    return TestReport("test_key_debounce");
+}
@@ -0,0 +1,150 @@
+// TM1639 BSRR波形(tm1639_wave.c)主机测试：回放生成的BSRR字，在STB为低时于CLK上升沿采样DIO，还原字节
+#include <string.h>
+#include "test.h"
+#include "tm1639_wave.h"
+
+// 与 main.h 中 PA3/PA4/PA5 相同
+static const TM1639WavePins_t pins = {1U << 3, 1U << 4, 1U << 5};
+
+// 模拟的总线：引脚电平和解码结果
+typedef struct
+{
+    uint16_t odr;           // 输出电平
+    uint8_t bytes[64];      // 锁存的字节
+    uint8_t count;          // 完整字节数
+    uint8_t bits;           // 当前字节已锁存的位数
+    uint8_t stray;          // STB为高时出现的CLK上升沿数
+    uint8_t strobes;        // STB下降沿数
+} Bus_t;
+
+static void BusReset(Bus_t *bus)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->odr = pins.clk | pins.dio | pins.stb; // 空闲时全部为高
+}
+
+// 写一个BSRR字：低16位置位，高16位复位(同时出现时置位优先)
+static void BusWrite(Bus_t *bus, uint32_t bsrr)
+{
+    uint16_t old = bus->odr;
+
+    bus->odr = (uint16_t)((old & ~(bsrr >> 16)) | (bsrr & 0xFFFFU));
+    if ((old & pins.stb) && !(bus->odr & pins.stb))
+    {
+        bus->strobes++;
+    }
+    if (!(old & pins.clk) && (bus->odr & pins.clk))
+    {
+        if (bus->odr & pins.stb)
+        {
+            bus->stray++;
+            return;
+        }
+        if (bus->odr & pins.dio)
+        {
+            bus->bytes[bus->count] |= (uint8_t)(1U << bus->bits); // 低位先发
+        }
+        if (++bus->bits == 8)
+        {
+            bus->bits = 0;
+            bus->count++;
+        }
+    }
+}
+
+// 按 TM1639DmaWriteFrame 的方式分块编码并回放一帧
+static uint8_t SendFrame(Bus_t *bus, const uint8_t *frame, uint8_t length)
+{
+    uint32_t buf[TM1639_DMA_BUF_WORDS];
+    uint8_t sent = 0, chunks = 0;
+    uint16_t words, i;
+
+    do
+    {
+        uint8_t chunk = length - sent;
+        if (chunk > TM1639_DMA_CHUNK_BYTES)
+        {
+            chunk = TM1639_DMA_CHUNK_BYTES;
+        }
+        memset(buf, 0xA5, sizeof(buf));
+        words = TM1639WaveEncode(buf, &pins, &frame[sent], chunk, sent == 0, sent + chunk == length);
+        CHECK(words <= TM1639_DMA_BUF_WORDS);
+        CHECK_EQ(words, chunk * 16 + (sent == 0 ? 2 : 0) + (sent + chunk == length ? 3 : 0));
+        for (i = 0; i < words; i++)
+        {
+            BusWrite(bus, buf[i]);
+        }
+        sent += chunk;
+        chunks++;
+        if (sent < length)
+        {
+            // 块之间STB保持低、CLK停在高电平
+            CHECK(!(bus->odr & pins.stb));
+            CHECK(bus->odr & pins.clk);
+        }
+    } while (sent < length);
+    return chunks;
+}
+
+/* 测试 ----------------------------------------------------------------------*/
+static void TestFrames(void)
+{
+    uint8_t frame[17];
+    uint8_t length, i, chunks;
+    Bus_t bus;
+
+    // 1 ~ 17 字节(地址命令 + 16字节显存)，覆盖整块和末尾不满4字节的块
+    for (length = 1; length <= sizeof(frame); length++)
+    {
+        for (i = 0; i < length; i++)
+        {
+            frame[i] = (uint8_t)(0xC0 + i * 37 + length);
+        }
+        BusReset(&bus);
+        chunks = SendFrame(&bus, frame, length);
+        CHECK_EQ(chunks, (length + TM1639_DMA_CHUNK_BYTES - 1) / TM1639_DMA_CHUNK_BYTES);
+        CHECK_EQ(bus.count, length);
+        CHECK_EQ(bus.bits, 0);
+        CHECK_EQ(bus.stray, 0);
+        CHECK_EQ(bus.strobes, 1);
+        CHECK(memcmp(bus.bytes, frame, length) == 0);
+        CHECK(bus.odr & pins.stb);      // 帧结束后STB拉高
+    }
+}
+
+static void TestPatterns(void)
+{
+    static const uint8_t patterns[] = {0x00, 0xFF, 0x01, 0x80, 0x55, 0xAA};
+    uint8_t frame[TM1639_DMA_CHUNK_BYTES + 1];
+    uint8_t p;
+    Bus_t bus;
+
+    for (p = 0; p < sizeof(patterns); p++)
+    {
+        memset(frame, patterns[p], sizeof(frame));
+        frame[sizeof(frame) - 1] = (uint8_t)~patterns[p];
+        BusReset(&bus);
+        SendFrame(&bus, frame, sizeof(frame));
+        CHECK_EQ(bus.count, sizeof(frame));
+        CHECK(memcmp(bus.bytes, frame, sizeof(frame)) == 0);
+    }
+}
+
+static void TestStrobeOnly(void)
+{
+    uint32_t buf[8];
+
+    // 不带STB的块只有数据位
+    CHECK_EQ(TM1639WaveEncode(buf, &pins, (const uint8_t *)"\x5A", 0, 0, 0), 0);
+    CHECK_EQ(TM1639WaveEncode(buf, &pins, (const uint8_t *)"\x5A", 0, 1, 1), 5);
+    CHECK_EQ(buf[0], (uint32_t)pins.stb << 16);
+    CHECK_EQ(buf[2], pins.stb);
+}
+
+int main(void)
+{
+    TestFrames();
+    TestPatterns();
+    TestStrobeOnly();
+    return TestReport("test_tm1639_wave");
+}